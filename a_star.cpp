@@ -1,184 +1,367 @@
 /*******************************************************
  * A* Algorithm Example in C++ for Grid Map Routing
  *
- * This program reads a grid from "map.txt" where
+ * This program reads a grid from "map.txt" (or a
+ * binary map file, see grid_file.h) where
  *   0 = walkable cell
  *   1 = obstacle cell
  * Then it runs A* to find a path between a start
  * and goal position and prints the path if found.
  *******************************************************/
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <queue>
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <stdexcept>
-
-// A small structure to hold basic node information.
-struct Node {
-    int row, col;
-    float gCost;  // Cost from start to current node
-    float hCost;  // Heuristic cost to goal
-    float fCost;  // gCost + hCost
-    Node* parent;
-    
-    Node(int r, int c) : row(r), col(c), gCost(0.0f), hCost(0.0f), fCost(0.0f), parent(nullptr) {}
-};
-
-// Comparator for the priority queue (min-heap based on fCost).
-struct CompareFCost {
-    bool operator()(const Node* a, const Node* b) {
-        return a->fCost > b->fCost;
-    }
-};
-
-// Heuristic function - using Manhattan distance for a grid.
-float heuristicManhattan(int row1, int col1, int row2, int col2) {
-    return static_cast<float>(std::abs(row1 - row2) + std::abs(col1 - col2));
-}
-
-// Check if a cell is within the map boundaries
-bool isValid(int row, int col, int rows, int cols) {
-    return (row >= 0 && row < rows && col >= 0 && col < cols);
-}
-
-// A* Search function
-std::vector<std::pair<int,int>> aStarSearch(const std::vector<std::vector<int>>& grid,
-                                           int startRow, int startCol,
-                                           int goalRow, int goalCol)
+#include <string>
+
+#include "a_star.h"
+#include "batch_query.h"
+#include "bidirectional_a_star.h"
+#include "bit_grid.h"
+#include "components.h"
+#include "grid_file.h"
+#include "grid_map.h"
+#include "hpa.h"
+#include "jps.h"
+#include "jps_plus.h"
+#include "parallel_bidirectional.h"
+#include "priority_queues.h"
+#include "search_context.h"
+
+// Print the grid with the path overlaid.
+// . = open, # = obstacle, P = path, S = start, G = goal
+void printGridWithPath(const GridMap& grid,
+                       const std::vector<std::pair<int,int>>& path,
+                       int startRow, int startCol,
+                       int goalRow, int goalCol)
 {
-    int rows = grid.size();
-    int cols = grid[0].size();
-
-    // Create a 2D array of Node pointers
-    std::vector<std::vector<Node*>> allNodes(rows, std::vector<Node*>(cols, nullptr));
-    for(int r = 0; r < rows; r++) {
-        for(int c = 0; c < cols; c++) {
-            allNodes[r][c] = new Node(r, c);
-        }
+    std::vector<bool> onPath(grid.size(), false);
+    for(auto &p : path) {
+        onPath[grid.index(p.first, p.second)] = true;
     }
 
-    // Keep track of visited cells
-    std::vector<std::vector<bool>> closedSet(rows, std::vector<bool>(cols, false));
-
-    // Priority queue for open set
-    std::priority_queue<Node*, std::vector<Node*>, CompareFCost> openSet;
-
-    // Initialize the start node
-    Node* startNode = allNodes[startRow][startCol];
-    startNode->gCost = 0.0f;
-    startNode->hCost = heuristicManhattan(startRow, startCol, goalRow, goalCol);
-    startNode->fCost = startNode->gCost + startNode->hCost;
-    openSet.push(startNode);
-
-    // Directions for 4-neighborhood (up, down, left, right)
-    int dRow[4] = {-1, 1, 0, 0};
-    int dCol[4] = {0, 0, -1, 1};
-
-    Node* goalNode = allNodes[goalRow][goalCol];
-
-    while(!openSet.empty()) {
-        Node* current = openSet.top();
-        openSet.pop();
-
-        // If this node is already closed, skip
-        if(closedSet[current->row][current->col])
-            continue;
-
-        // Mark current node as visited
-        closedSet[current->row][current->col] = true;
-
-        // Check if we reached the goal
-        if(current == goalNode) {
-            // Reconstruct path
-            std::vector<std::pair<int,int>> path;
-            Node* temp = goalNode;
-            while(temp != nullptr) {
-                path.push_back({temp->row, temp->col});
-                temp = temp->parent;
+    for(int r = 0; r < grid.rows(); r++) {
+        for(int c = 0; c < grid.cols(); c++) {
+            if(r == startRow && c == startCol) {
+                std::cout << "S ";
+            } else if(r == goalRow && c == goalCol) {
+                std::cout << "G ";
+            } else if(grid.blocked(r, c)) {
+                std::cout << "# ";
+            } else if(onPath[grid.index(r, c)]) {
+                std::cout << "P ";
+            } else {
+                std::cout << ". ";
             }
-            // Reverse path to get start -> goal
-            std::reverse(path.begin(), path.end());
-
-            // Clean up allocated memory
-            for(int r = 0; r < rows; r++) {
-                for(int c = 0; c < cols; c++) {
-                    delete allNodes[r][c];
-                }
-            }
-            return path;
         }
+        std::cout << "\n";
+    }
+}
 
-        // Explore neighbors
-        for(int i = 0; i < 4; i++) {
-            int nr = current->row + dRow[i];
-            int nc = current->col + dCol[i];
-
-            if(!isValid(nr, nc, rows, cols)) continue;     // out of bounds
-            if(grid[nr][nc] == 1) continue;                // obstacle
-            if(closedSet[nr][nc]) continue;                // already in closed set
-
-            Node* neighbor = allNodes[nr][nc];
+// Runs the selected algorithm with a fresh open set of the given type.
+template <class OpenSet>
+std::vector<std::pair<int,int>> runSearch(const std::string& algorithm,
+                                         const GridMap& grid, SearchContext& ctx,
+                                         int startRow, int startCol,
+                                         int goalRow, int goalCol,
+                                         Connectivity connectivity,
+                                         const JpsPlusTable& jpsTable,
+                                         const HpaGraph& hpaGraph)
+{
+    OpenSet openSet;
+    if(algorithm == "bidir") {
+        SearchContext backwardCtx(grid);
+        OpenSet backwardOpen;
+        BidirectionalStats stats;
+        auto path = bidirectionalAStarSearch(grid, ctx, backwardCtx, openSet, backwardOpen,
+                                             startRow, startCol, goalRow, goalCol, connectivity, &stats);
+        std::cerr << "Expanded " << stats.forwardExpansions << " cells forward and "
+                  << stats.backwardExpansions << " backward\n";
+        return path;
+    }
+    if(algorithm == "bidir-parallel") {
+        ParallelBidirectionalSearch<OpenSet> search(grid.size());
+        BidirectionalStats stats;
+        auto path = parallelBidirectionalAStarSearch(grid, search, startRow, startCol, goalRow, goalCol,
+                                                     connectivity, &stats);
+        std::cerr << "Expanded " << stats.forwardExpansions << " cells forward and "
+                  << stats.backwardExpansions << " backward\n";
+        return path;
+    }
+    if(algorithm == "hpa") {
+        return hpaSearch(grid, hpaGraph, ctx, openSet, startRow, startCol, goalRow, goalCol);
+    }
+    if(algorithm == "jps+") {
+        return jpsPlusSearch(grid, jpsTable, ctx, openSet, startRow, startCol, goalRow, goalCol);
+    }
+    if(algorithm == "jps-bits") {
+        BitGrid bits(grid);
+        return jumpPointSearch(grid, bits, ctx, openSet, startRow, startCol, goalRow, goalCol, connectivity);
+    }
+    if(algorithm == "jps") {
+        return jumpPointSearch(grid, ctx, openSet, startRow, startCol, goalRow, goalCol, connectivity);
+    }
+    return aStarSearch(grid, ctx, openSet, startRow, startCol, goalRow, goalCol, connectivity);
+}
 
-            float tentativeGCost = current->gCost + 1.0f; // Cost from current to neighbor
-            if(tentativeGCost < neighbor->gCost || neighbor->parent == nullptr) {
-                neighbor->gCost = tentativeGCost;
-                neighbor->hCost = heuristicManhattan(nr, nc, goalRow, goalCol);
-                neighbor->fCost = neighbor->gCost + neighbor->hCost;
-                neighbor->parent = current;
-                openSet.push(neighbor);
+// Reads "startRow startCol goalRow goalCol" lines until EOF. Throws if a
+// line is malformed or names a cell that is off the map or blocked.
+std::vector<GridQuery> readQueries(std::istream& in, const GridMap& grid) {
+    std::vector<GridQuery> queries;
+    GridQuery q;
+    while(in >> q.startRow >> q.startCol >> q.goalRow >> q.goalCol) {
+        for(auto cell : {std::make_pair(q.startRow, q.startCol), std::make_pair(q.goalRow, q.goalCol)}) {
+            if(cell.first < 0 || cell.first >= grid.rows() || cell.second < 0 || cell.second >= grid.cols() ||
+               grid.blocked(cell.first, cell.second)) {
+                throw std::runtime_error("Query " + std::to_string(queries.size()) +
+                                         " starts or ends off the map or on an obstacle");
             }
         }
+        queries.push_back(q);
+    }
+    if(!in.eof()) {
+        throw std::runtime_error("Malformed query after query " + std::to_string(queries.size()));
     }
+    return queries;
+}
 
-    // If we exit the loop, no path was found
-    // Clean up allocated memory
-    for(int r = 0; r < rows; r++) {
-        for(int c = 0; c < cols; c++) {
-            delete allNodes[r][c];
+// Answers a batch of queries on numThreads workers and prints one line
+// per query, in input order, then each worker's share of the work.
+template <class OpenSet>
+void runBatch(const GridMap& grid, Connectivity connectivity,
+              const std::vector<GridQuery>& queries, int numThreads)
+{
+    BatchPathfinder<OpenSet> pathfinder(grid, connectivity, numThreads);
+    auto begin = std::chrono::steady_clock::now();
+    auto paths = pathfinder.run(queries);
+    auto end = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < queries.size(); i++) {
+        const GridQuery& q = queries[i];
+        std::cout << "(" << q.startRow << ", " << q.startCol << ") -> ("
+                  << q.goalRow << ", " << q.goalCol << "): ";
+        if(paths[i].empty()) {
+            std::cout << "No path found.\n";
+        } else {
+            std::cout << paths[i].size() << " steps\n";
         }
     }
+    std::cerr << "Answered " << queries.size() << " queries in "
+              << std::chrono::duration<double, std::milli>(end - begin).count()
+              << " ms on " << pathfinder.numThreads() << " threads\n";
+    const auto& stats = pathfinder.workerStats();
+    for(size_t w = 0; w < stats.size(); w++) {
+        std::cerr << "  worker " << w << ": " << stats[w].tasks << " queries, "
+                  << stats[w].steals << " steals, busy " << stats[w].busySeconds * 1000
+                  << " ms, idle " << stats[w].idleSeconds * 1000 << " ms\n";
+    }
+}
 
-    return {}; // Return empty path to indicate failure
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --map FILE           text or binary map to load (default map.txt)\n"
+              << "  --algorithm NAME     astar (default), jps (Jump Point Search),\n"
+              << "                       jps-bits (JPS scanning bit-packed rows),\n"
+              << "                       jps+ (JPS with precomputed jump distances),\n"
+              << "                       bidir (bidirectional A*), bidir-parallel\n"
+              << "                       (both directions on their own threads), or\n"
+              << "                       hpa (hierarchical A*, near-optimal)\n"
+              << "  --connectivity 4|8   neighbours per cell (default 4); diagonal\n"
+              << "                       moves may not cut corners\n"
+              << "  --open-set NAME      A* open set: heap (binary heap, default),\n"
+              << "                       bucket (Dial's bucket queue), or\n"
+              << "                       indexed/indexed8 (4-/8-ary heap with decrease-key)\n"
+              << "  --jps-table FILE     jps+ table to load, or to build and save if\n"
+              << "                       FILE does not exist yet\n"
+              << "  --cluster-size N     hpa cluster width and height (default 16)\n"
+              << "  --queries FILE       answer \"startRow startCol goalRow goalCol\" lines\n"
+              << "                       from FILE (- for stdin) with A* on a thread pool\n"
+              << "  --threads N          threads for preprocessing and --queries\n"
+              << "                       (default: all cores)\n"
+              << "  --convert FILE       write the map to FILE in the binary format and exit\n"
+              << "  --encoding NAME      binary cell encoding: bytes (memory-mapped in\n"
+              << "                       place, default) or bits (8x smaller, unpacked on load)\n";
 }
 
-int main() {
-    // Read the map from a file
-    std::ifstream fin("map.txt");
-    if(!fin.is_open()) {
-        std::cerr << "Error: Could not open map.txt\n";
+int main(int argc, char* argv[]) {
+    std::string mapFile = "map.txt";
+    std::string openSetName = "heap";
+    std::string convertFile;
+    std::string encodingName = "bytes";
+    std::string algorithm = "astar";
+    std::string connectivityName = "4";
+    std::string jpsTableFile;
+    int clusterSize = 16;
+    std::string queryFile;
+    int numThreads = 0;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--map" && i + 1 < argc) {
+            mapFile = argv[++i];
+        } else if(arg == "--open-set" && i + 1 < argc) {
+            openSetName = argv[++i];
+        } else if(arg == "--convert" && i + 1 < argc) {
+            convertFile = argv[++i];
+        } else if(arg == "--encoding" && i + 1 < argc) {
+            encodingName = argv[++i];
+        } else if(arg == "--algorithm" && i + 1 < argc) {
+            algorithm = argv[++i];
+        } else if(arg == "--connectivity" && i + 1 < argc) {
+            connectivityName = argv[++i];
+        } else if(arg == "--jps-table" && i + 1 < argc) {
+            jpsTableFile = argv[++i];
+        } else if(arg == "--cluster-size" && i + 1 < argc) {
+            clusterSize = std::atoi(argv[++i]);
+        } else if(arg == "--queries" && i + 1 < argc) {
+            queryFile = argv[++i];
+        } else if(arg == "--threads" && i + 1 < argc) {
+            numThreads = std::atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(openSetName != "heap" && openSetName != "bucket" &&
+       openSetName != "indexed" && openSetName != "indexed8") {
+        std::cerr << "Unknown open set: " << openSetName << "\n";
+        return 1;
+    }
+    if(algorithm != "astar" && algorithm != "jps" &&
+       algorithm != "jps-bits" && algorithm != "jps+" && algorithm != "hpa" &&
+       algorithm != "bidir" && algorithm != "bidir-parallel") {
+        std::cerr << "Unknown algorithm: " << algorithm << "\n";
+        return 1;
+    }
+    if(connectivityName != "4" && connectivityName != "8") {
+        std::cerr << "Connectivity must be 4 or 8\n";
+        return 1;
+    }
+    Connectivity connectivity = connectivityName == "8" ? Connectivity::Eight : Connectivity::Four;
+    if(encodingName != "bytes" && encodingName != "bits") {
+        std::cerr << "Unknown encoding: " << encodingName << "\n";
+        return 1;
+    }
+    if(!queryFile.empty() && algorithm != "astar") {
+        std::cerr << "--queries only supports --algorithm astar\n";
         return 1;
     }
 
-    int rows, cols;
-    fin >> rows >> cols;
-    if(rows <= 0 || cols <= 0) {
-        std::cerr << "Invalid map dimensions.\n";
+    // Read the map from a file (text, or binary which is memory-mapped)
+    GridMap grid;
+    try {
+        grid = loadGridFile(mapFile);
+        if(!convertFile.empty()) {
+            writeGridFile(convertFile, grid,
+                          encodingName == "bits" ? kGridEncodingBits : kGridEncodingBytes);
+            std::cerr << "Wrote " << grid.rows() << "x" << grid.cols()
+                      << " map to " << convertFile << "\n";
+            return 0;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
         return 1;
     }
 
-    std::vector<std::vector<int>> grid(rows, std::vector<int>(cols));
+    // Batch mode: many queries against the same map on a worker pool
+    if(!queryFile.empty()) {
+        try {
+            std::vector<GridQuery> queries;
+            if(queryFile == "-") {
+                queries = readQueries(std::cin, grid);
+            } else {
+                std::ifstream in(queryFile);
+                if(!in) {
+                    throw std::runtime_error("Could not open " + queryFile);
+                }
+                queries = readQueries(in, grid);
+            }
+            if(openSetName == "bucket") {
+                runBatch<BucketQueue>(grid, connectivity, queries, numThreads);
+            } else if(openSetName == "indexed") {
+                runBatch<IndexedDaryHeap<4>>(grid, connectivity, queries, numThreads);
+            } else if(openSetName == "indexed8") {
+                runBatch<IndexedDaryHeap<8>>(grid, connectivity, queries, numThreads);
+            } else {
+                runBatch<BinaryHeap>(grid, connectivity, queries, numThreads);
+            }
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
 
-    for(int r = 0; r < rows; r++) {
-        for(int c = 0; c < cols; c++) {
-            fin >> grid[r][c];
+    // JPS+ preprocessing: reuse a saved table when one exists for this map
+    JpsPlusTable jpsTable;
+    if(algorithm == "jps+") {
+        try {
+            std::ifstream existing(jpsTableFile);
+            if(!jpsTableFile.empty() && existing.is_open()) {
+                jpsTable = mapJpsPlusFile(jpsTableFile, grid);
+                if(jpsTable.connectivity() != connectivity) {
+                    throw std::runtime_error(jpsTableFile + " was built for the other connectivity");
+                }
+            } else {
+                jpsTable = JpsPlusTable::build(grid, connectivity, numThreads);
+                if(!jpsTableFile.empty()) {
+                    writeJpsPlusFile(jpsTableFile, jpsTable, grid);
+                }
+            }
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
         }
     }
-    fin.close();
+
+    // HPA* preprocessing: clusters are built in parallel
+    HpaGraph hpaGraph;
+    if(algorithm == "hpa") {
+        try {
+            hpaGraph = HpaGraph(grid, clusterSize, connectivity, numThreads);
+        } catch(const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    int rows = grid.rows(), cols = grid.cols();
 
     // Define start and goal (change as needed)
     int startRow = 0, startCol = 0;
     int goalRow = rows - 1, goalCol = cols - 1;
 
     // Make sure start and goal are valid
-    if(grid[startRow][startCol] == 1 || grid[goalRow][goalCol] == 1) {
+    if(grid.blocked(startRow, startCol) || grid.blocked(goalRow, goalCol)) {
         std::cerr << "Start or goal is on an obstacle. Exiting.\n";
         return 1;
     }
 
-    // Run A*
-    auto path = aStarSearch(grid, startRow, startCol, goalRow, goalCol);
+    // A goal in another component would make the search explore everything
+    // the start can reach; the labels settle that in one pass over the map
+    GridComponents components(grid, numThreads);
+    if(!components.connected(grid.index(startRow, startCol), grid.index(goalRow, goalCol))) {
+        std::cout << "No path found.\n";
+        return 0;
+    }
+
+    // Run the search (the context can be reused for further queries on this map)
+    SearchContext ctx(grid);
+    std::vector<std::pair<int,int>> path;
+    if(openSetName == "bucket") {
+        path = runSearch<BucketQueue>(algorithm, grid, ctx, startRow, startCol, goalRow, goalCol, connectivity, jpsTable, hpaGraph);
+    } else if(openSetName == "indexed") {
+        path = runSearch<IndexedDaryHeap<4>>(algorithm, grid, ctx, startRow, startCol, goalRow, goalCol, connectivity, jpsTable, hpaGraph);
+    } else if(openSetName == "indexed8") {
+        path = runSearch<IndexedDaryHeap<8>>(algorithm, grid, ctx, startRow, startCol, goalRow, goalCol, connectivity, jpsTable, hpaGraph);
+    } else {
+        path = runSearch<BinaryHeap>(algorithm, grid, ctx, startRow, startCol, goalRow, goalCol, connectivity, jpsTable, hpaGraph);
+    }
 
     // Check result
     if(path.empty()) {
@@ -191,34 +374,8 @@ int main() {
         }
         std::cout << "\n";
 
-        // Mark path on the grid for visualization
-        for(auto &p : path) {
-            // Mark with 'P'
-            if(!(p.first == startRow && p.second == startCol) && 
-               !(p.first == goalRow && p.second == goalCol))
-            {
-                grid[p.first][p.second] = 2; 
-            }
-        }
-
         // Print grid with path
-        // 0 = open, 1 = obstacle, 2 = path, S = start, G = goal
-        for(int r = 0; r < rows; r++) {
-            for(int c = 0; c < cols; c++) {
-                if(r == startRow && c == startCol) {
-                    std::cout << "S ";
-                } else if(r == goalRow && c == goalCol) {
-                    std::cout << "G ";
-                } else if(grid[r][c] == 0) {
-                    std::cout << ". ";
-                } else if(grid[r][c] == 1) {
-                    std::cout << "# ";
-                } else if(grid[r][c] == 2) {
-                    std::cout << "P ";
-                }
-            }
-            std::cout << "\n";
-        }
+        printGridWithPath(grid, path, startRow, startCol, goalRow, goalCol);
     }
 
     return 0;
@@ -0,0 +1,174 @@
+/*******************************************************
+ * A* search over a GridMap
+ *
+ * 4-connected moves with unit cost and the Manhattan
+ * heuristic, or 8-connected moves (no corner cutting)
+ * with fixed-point octile costs. The open set
+ * implementation is a template parameter (see
+ * priority_queues.h).
+ *******************************************************/
+
+#ifndef A_STAR_H
+#define A_STAR_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "grid_map.h"
+#include "priority_queues.h"
+#include "search_context.h"
+
+enum class Connectivity { Four, Eight };
+
+// 4-connected moves cost 1. 8-connected moves are costed in fixed point
+// so g stays an integer: a straight step costs 10 and a diagonal 14.
+// A diagonal step is only allowed when both cells it cuts past are free.
+const int kStraightCost8 = 10;
+const int kDiagonalCost8 = 14;
+
+// Heuristic function - using Manhattan distance for a grid.
+inline int heuristicManhattan(int row1, int col1, int row2, int col2) {
+    return std::abs(row1 - row2) + std::abs(col1 - col2);
+}
+
+// Octile distance in kStraightCost8/kDiagonalCost8 units.
+inline int heuristicOctile(int row1, int col1, int row2, int col2) {
+    int dRow = std::abs(row1 - row2);
+    int dCol = std::abs(col1 - col2);
+    return kDiagonalCost8 * std::min(dRow, dCol) + kStraightCost8 * std::abs(dRow - dCol);
+}
+
+inline int gridHeuristic(Connectivity connectivity, int row1, int col1, int row2, int col2) {
+    return connectivity == Connectivity::Four ? heuristicManhattan(row1, col1, row2, col2)
+                                              : heuristicOctile(row1, col1, row2, col2);
+}
+
+// Follows parent links from goalIdx back to the start. Consecutive
+// entries may be any distance apart along a straight or diagonal line
+// (e.g. jump points); the cells in between are filled in.
+inline std::vector<std::pair<int,int>> tracePath(const GridMap& grid,
+                                                const SearchContext& ctx,
+                                                int goalIdx)
+{
+    std::vector<std::pair<int,int>> path;
+    for(int idx = goalIdx; idx != -1; idx = ctx.parent(idx)) {
+        int row = grid.rowOf(idx), col = grid.colOf(idx);
+        path.push_back({row, col});
+        int parent = ctx.parent(idx);
+        if(parent == -1) break;
+        int stepRow = (grid.rowOf(parent) > row) - (grid.rowOf(parent) < row);
+        int stepCol = (grid.colOf(parent) > col) - (grid.colOf(parent) < col);
+        for(row += stepRow, col += stepCol; grid.index(row, col) != parent;
+            row += stepRow, col += stepCol) {
+            path.push_back({row, col});
+        }
+    }
+    // Reverse path to get start -> goal
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// A* Search function. The context must have been built for this grid
+// and can be reused for any number of queries on it. OpenSet is one of
+// the queues in priority_queues.h, keyed by fCost; like the context it
+// can be kept by the caller to avoid reallocating between queries.
+template <class OpenSet>
+std::vector<std::pair<int,int>> aStarSearch(const GridMap& grid,
+                                           SearchContext& ctx,
+                                           OpenSet& openSet,
+                                           int startRow, int startCol,
+                                           int goalRow, int goalCol,
+                                           Connectivity connectivity = Connectivity::Four)
+{
+    ctx.checkGrid(grid);
+    ctx.beginQuery();
+    openSet.reset(grid.size());
+
+    // Initialize the start node
+    int startIdx = grid.index(startRow, startCol);
+    ctx.update(startIdx, 0, -1);
+    openSet.push(gridHeuristic(connectivity, startRow, startCol, goalRow, goalCol), startIdx);
+
+    // Directions: up, down, left, right, then the diagonals. A diagonal
+    // move i >= 4 cuts past the cardinal cells sideA[i] and sideB[i].
+    const int dRow[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+    const int dCol[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+    const int sideA[8] = {0, 0, 0, 0, 0, 0, 1, 1};
+    const int sideB[8] = {0, 0, 0, 0, 2, 3, 2, 3};
+    int offsets[8];
+    for(int i = 0; i < 8; i++) {
+        offsets[i] = dRow[i] * grid.stride() + dCol[i];
+    }
+    const bool eight = connectivity == Connectivity::Eight;
+    const int numDirs = eight ? 8 : 4;
+    const int straightCost = eight ? kStraightCost8 : 1;
+
+    int goalIdx = grid.index(goalRow, goalCol);
+
+    while(!openSet.empty()) {
+        int currentIdx = openSet.pop().second;
+
+        // If this node is already closed, skip
+        if(ctx.isClosed(currentIdx))
+            continue;
+
+        // Mark current node as visited
+        ctx.close(currentIdx);
+
+        // Check if we reached the goal
+        if(currentIdx == goalIdx) {
+            return tracePath(grid, ctx, goalIdx);
+        }
+
+        int row = grid.rowOf(currentIdx);
+        int col = grid.colOf(currentIdx);
+        int gCost = ctx.g(currentIdx);
+
+        // Explore neighbors; the border is blocked, so no bounds check
+        for(int i = 0; i < numDirs; i++) {
+            int nIdx = currentIdx + offsets[i];
+
+            if(grid.blocked(nIdx)) continue;               // obstacle or border
+            if(ctx.isClosed(nIdx)) continue;               // already in closed set
+
+            int stepCost = straightCost;
+            if(i >= 4) {
+                if(grid.blocked(currentIdx + offsets[sideA[i]]) ||
+                   grid.blocked(currentIdx + offsets[sideB[i]])) continue;  // corner cutting
+                stepCost = kDiagonalCost8;
+            }
+
+            int tentativeGCost = gCost + stepCost; // Cost from current to neighbor
+            if(!ctx.visited(nIdx) || tentativeGCost < ctx.g(nIdx)) {
+                ctx.update(nIdx, tentativeGCost, currentIdx);
+                int hCost = gridHeuristic(connectivity, row + dRow[i], col + dCol[i], goalRow, goalCol);
+                openSet.push(tentativeGCost + hCost, nIdx);
+            }
+        }
+    }
+
+    return {}; // Return empty path to indicate failure
+}
+
+// A* with the default binary-heap open set.
+inline std::vector<std::pair<int,int>> aStarSearch(const GridMap& grid,
+                                                  SearchContext& ctx,
+                                                  int startRow, int startCol,
+                                                  int goalRow, int goalCol)
+{
+    BinaryHeap openSet;
+    return aStarSearch(grid, ctx, openSet, startRow, startCol, goalRow, goalCol);
+}
+
+// Convenience overload for a single query; allocates a fresh context.
+inline std::vector<std::pair<int,int>> aStarSearch(const GridMap& grid,
+                                                  int startRow, int startCol,
+                                                  int goalRow, int goalCol)
+{
+    SearchContext ctx(grid);
+    return aStarSearch(grid, ctx, startRow, startCol, goalRow, goalCol);
+}
+
+#endif // A_STAR_H
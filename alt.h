@@ -0,0 +1,309 @@
+/*******************************************************
+ * ALT - A*, Landmarks and the Triangle inequality
+ *
+ * Graph vertices have no coordinates, so A* needs another
+ * lower bound on the distance to the target. For a few
+ * landmark vertices L we store d(L, v) and d(v, L) for
+ * every v; the triangle inequality then gives
+ *   d(v, t) >= d(L, t) - d(L, v)
+ *   d(v, t) >= d(v, L) - d(t, L)
+ * and the best bound over all landmarks is a consistent
+ * heuristic. Landmarks are chosen "farthest": each new
+ * one is the vertex farthest from those picked so far, so
+ * they end up on the edge of the graph, behind most
+ * targets as seen from most sources.
+ *
+ * Tables are vertex-major (all landmarks of a vertex are
+ * adjacent) and can be written to a file that query
+ * processes memory-map and share, like graph_file.h. The
+ * file records a checksum of the graph's edges, since
+ * distances from another graph - even one with the same
+ * shape - would make the bounds wrong.
+ *******************************************************/
+
+#ifndef ALT_H
+#define ALT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "dijkstra.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "priority_queues.h"
+
+class LandmarkTable {
+public:
+    LandmarkTable() = default;
+
+    // Views k landmark ids and n * 2k distances kept alive by owner.
+    LandmarkTable(int numVertices, int numLandmarks, const int* landmarks,
+                  const int* distances, std::shared_ptr<const void> owner)
+        : n_(numVertices), k_(numLandmarks), landmarks_(landmarks),
+          distances_(distances), owner_(std::move(owner))
+    {}
+
+    // Picks numLandmarks landmarks (farthest strategy) and runs dijkstra
+    // from each on graph and on its reverse, numThreads at a time.
+    static LandmarkTable build(const CsrGraph& graph, int numLandmarks, int numThreads = 0);
+
+    int numVertices() const { return n_; }
+    int numLandmarks() const { return k_; }
+    int landmark(int i) const { return landmarks_[i]; }
+
+    // d(landmark i, v) and d(v, landmark i); INT_MAX if unreachable.
+    int fromLandmark(int i, int v) const { return distances_[static_cast<size_t>(v) * 2 * k_ + i]; }
+    int toLandmark(int i, int v) const { return distances_[static_cast<size_t>(v) * 2 * k_ + k_ + i]; }
+
+    // Lower bound on d(v, t). INT_MAX means the landmarks prove that t
+    // cannot be reached from v.
+    int lowerBound(int v, int t) const {
+        const int INF = std::numeric_limits<int>::max();
+        const int* dv = distances_ + static_cast<size_t>(v) * 2 * k_;
+        const int* dt = distances_ + static_cast<size_t>(t) * 2 * k_;
+        int bound = 0;
+        for(int i = 0; i < k_; i++) {
+            if(dv[i] != INF) {
+                if(dt[i] == INF) return INF;  // L reaches v but not t
+                bound = std::max(bound, dt[i] - dv[i]);
+            }
+            if(dt[k_ + i] != INF) {
+                if(dv[k_ + i] == INF) return INF;  // t reaches L but v does not
+                bound = std::max(bound, dv[k_ + i] - dt[k_ + i]);
+            }
+        }
+        return bound;
+    }
+
+    // Raw arrays: numLandmarks() ids, numVertices() * 2 * numLandmarks()
+    // distances.
+    const int* landmarks() const { return landmarks_; }
+    const int* distances() const { return distances_; }
+
+private:
+    int n_ = 0;
+    int k_ = 0;
+    const int* landmarks_ = nullptr;
+    const int* distances_ = nullptr;
+    std::shared_ptr<const void> owner_;
+};
+
+inline LandmarkTable LandmarkTable::build(const CsrGraph& graph, int numLandmarks, int numThreads) {
+    const int INF = std::numeric_limits<int>::max();
+    int n = graph.numVertices();
+    int k = std::max(0, std::min(numLandmarks, n));
+
+    // Each landmark is the vertex farthest from all earlier ones; vertices
+    // none of them reach count as farthest, so every part of the graph
+    // gets covered. The search from vertex 0 only seeds the first pick.
+    std::vector<int> landmarks;
+    std::vector<std::vector<int>> from;
+    std::vector<int> nearest = n > 0 ? dijkstra(graph, 0) : std::vector<int>();
+    for(int i = 0; i < k; i++) {
+        int best = -1;
+        for(int v = 0; v < n; v++) {
+            if(std::find(landmarks.begin(), landmarks.end(), v) != landmarks.end()) continue;
+            if(best == -1 || nearest[v] > nearest[best]) best = v;
+        }
+        landmarks.push_back(best);
+        from.push_back(dijkstra(graph, best));
+        if(i == 0) std::fill(nearest.begin(), nearest.end(), INF);
+        for(int v = 0; v < n; v++) nearest[v] = std::min(nearest[v], from.back()[v]);
+    }
+
+    CsrGraph reverse = reverseCsrGraph(graph);
+    std::vector<std::vector<int>> to(k);
+    parallelFor(0, k, [&](int i) {
+        to[i] = dijkstra(reverse, landmarks[i]);
+    }, numThreads);
+
+    struct Storage {
+        std::vector<int> landmarks;
+        std::vector<int> distances;
+    };
+    auto storage = std::make_shared<Storage>();
+    storage->landmarks = landmarks;
+    storage->distances.resize(static_cast<size_t>(n) * 2 * k);
+    for(int v = 0; v < n; v++) {
+        int* row = storage->distances.data() + static_cast<size_t>(v) * 2 * k;
+        for(int i = 0; i < k; i++) {
+            row[i] = from[i][v];
+            row[k + i] = to[i][v];
+        }
+    }
+    const int* ids = storage->landmarks.data();
+    const int* distances = storage->distances.data();
+    return LandmarkTable(n, k, ids, distances, std::move(storage));
+}
+
+// Goal-directed A* on a CsrGraph using a LandmarkTable built for it.
+// Holds per-vertex search state; create one per thread and reuse it.
+class AltQuery {
+public:
+    AltQuery(const CsrGraph& graph, const LandmarkTable& table)
+        : graph_(&graph), table_(&table), g_(graph.numVertices()), h_(graph.numVertices()),
+          stamp_(graph.numVertices(), 0), closed_(graph.numVertices(), 0)
+    {
+        if(table.numVertices() != graph.numVertices()) {
+            throw std::invalid_argument("LandmarkTable does not match graph");
+        }
+    }
+
+    // Shortest distance from source to target, or INT_MAX if unreachable.
+    int distance(int source, int target) {
+        const int INF = std::numeric_limits<int>::max();
+        if(++current_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            std::fill(closed_.begin(), closed_.end(), 0);
+            current_ = 1;
+        }
+        settled_ = 0;
+        heap_.reset(graph_->numVertices());
+
+        int h = table_->lowerBound(source, target);
+        if(h == INF) return INF;
+        visit(source, 0, h);
+        heap_.push(h, source);
+        while(!heap_.empty()) {
+            int u = heap_.pop().second;
+            if(closed_[u] == current_) continue;
+            closed_[u] = current_;
+            settled_++;
+            if(u == target) return g_[u];
+
+            for(int64_t e = graph_->edgeBegin(u); e < graph_->edgeEnd(u); e++) {
+                int v = graph_->target(e);
+                int g = g_[u] + graph_->weight(e);
+                if(stamp_[v] == current_) {
+                    if(closed_[v] == current_ || g >= g_[v]) continue;
+                    g_[v] = g;
+                } else {
+                    int hv = table_->lowerBound(v, target);
+                    if(hv == INF) continue;  // cannot lead to target
+                    visit(v, g, hv);
+                }
+                heap_.push(g + h_[v], v);
+            }
+        }
+        return INF;
+    }
+
+    // Vertices settled by the last query.
+    int settled() const { return settled_; }
+
+private:
+    void visit(int v, int g, int h) {
+        g_[v] = g;
+        h_[v] = h;
+        stamp_[v] = current_;
+    }
+
+    const CsrGraph* graph_;
+    const LandmarkTable* table_;
+    std::vector<int> g_;
+    std::vector<int> h_;
+    std::vector<uint32_t> stamp_;
+    std::vector<uint32_t> closed_;
+    uint32_t current_ = 0;
+    BinaryHeap heap_;
+    int settled_ = 0;
+};
+
+/*
+ * Landmark files (host byte order):
+ *   LandmarkFileHeader                   40 bytes
+ *   landmarks[numLandmarks]              int32, padded to 8 bytes
+ *   distances[numVertices][2 * numLandmarks]  int32
+ * The graph's size and checksum are recorded so a table is not used
+ * with another graph.
+ */
+struct LandmarkFileHeader {
+    char magic[8];         // "ALTLMRK1"
+    uint32_t version;      // kLandmarkFileVersion
+    uint32_t byteOrder;    // kLandmarkFileByteOrder as written by the producer
+    uint32_t numVertices;
+    uint32_t numLandmarks;
+    uint64_t numEdges;
+    uint64_t graphChecksum; // csrGraphChecksum() of the graph the table was built for
+};
+
+static_assert(sizeof(LandmarkFileHeader) == 40, "LandmarkFileHeader must stay 40 bytes");
+
+const char kLandmarkFileMagic[8] = {'A', 'L', 'T', 'L', 'M', 'R', 'K', '1'};
+const uint32_t kLandmarkFileVersion = 2;
+const uint32_t kLandmarkFileByteOrder = 0x01020304;
+
+inline uint64_t landmarkFileDistancesOffset(uint64_t k) {
+    return sizeof(LandmarkFileHeader) + ((4 * k + 7) & ~uint64_t(7));
+}
+
+inline void writeLandmarkFile(const std::string& path, const LandmarkTable& table, const CsrGraph& graph) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        throw std::runtime_error("Could not create " + path);
+    }
+    uint64_t n = table.numVertices();
+    uint64_t k = table.numLandmarks();
+
+    LandmarkFileHeader header;
+    std::memcpy(header.magic, kLandmarkFileMagic, sizeof(header.magic));
+    header.version = kLandmarkFileVersion;
+    header.byteOrder = kLandmarkFileByteOrder;
+    header.numVertices = static_cast<uint32_t>(n);
+    header.numLandmarks = static_cast<uint32_t>(k);
+    header.numEdges = static_cast<uint64_t>(graph.numEdges());
+    header.graphChecksum = csrGraphChecksum(graph);
+
+    const char padding[8] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.landmarks()), 4 * k);
+    out.write(padding, landmarkFileDistancesOffset(k) - sizeof(header) - 4 * k);
+    out.write(reinterpret_cast<const char*>(table.distances()), 4 * n * 2 * k);
+    if(!out.flush()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+// Maps a file written by writeLandmarkFile; throws unless it was built
+// for exactly the edges of graph.
+inline LandmarkTable mapLandmarkFile(const std::string& path, const CsrGraph& graph) {
+    auto file = std::make_shared<MappedFile>(path);
+    if(file->size() < sizeof(LandmarkFileHeader)) {
+        throw std::runtime_error(path + " is too small to be a landmark file");
+    }
+    LandmarkFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(std::memcmp(header.magic, kLandmarkFileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a landmark file");
+    }
+    if(header.byteOrder != kLandmarkFileByteOrder) {
+        throw std::runtime_error(path + " was written with a different byte order");
+    }
+    if(header.version != kLandmarkFileVersion) {
+        throw std::runtime_error(path + " has unsupported landmark file version " +
+                                 std::to_string(header.version));
+    }
+    if(header.numVertices != static_cast<uint32_t>(graph.numVertices()) ||
+       header.numEdges != static_cast<uint64_t>(graph.numEdges()) ||
+       header.graphChecksum != csrGraphChecksum(graph)) {
+        throw std::runtime_error(path + " was built for a different graph");
+    }
+    uint64_t n = header.numVertices, k = header.numLandmarks;
+    if(k > n || file->size() != landmarkFileDistancesOffset(k) + 4 * n * 2 * k) {
+        throw std::runtime_error(path + " has an inconsistent size");
+    }
+    auto landmarks = reinterpret_cast<const int*>(file->data() + sizeof(LandmarkFileHeader));
+    auto distances = reinterpret_cast<const int*>(file->data() + landmarkFileDistancesOffset(k));
+    return LandmarkTable(static_cast<int>(n), static_cast<int>(k), landmarks, distances, std::move(file));
+}
+
+#endif // ALT_H
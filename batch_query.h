@@ -0,0 +1,151 @@
+/*******************************************************
+ * Batch A* and Dijkstra queries on a worker pool
+ *
+ * Many independent queries against one map or graph are
+ * spread over a WorkerPool (parallel.h). The map or graph
+ * is only read, so all workers share it; each worker owns
+ * its search state (SearchContext and open set, or a
+ * PointToPointDijkstra), which is reused from query to
+ * query exactly as a single-threaded caller would reuse
+ * it. Results come back in the order of the queries.
+ *
+ * Query costs vary wildly - neighbouring cells versus the
+ * whole map for an unreachable goal - so batches are
+ * scheduled by work stealing, and the per-worker busy and
+ * idle times of the last batch are kept for inspection.
+ * Connected components (components.h) are labelled when a
+ * batch engine is built, so queries between different
+ * components are answered without searching at all. Grid
+ * labels are kept current when cells are edited through
+ * BatchPathfinder::setBlocked between batches.
+ *******************************************************/
+
+#ifndef BATCH_QUERY_H
+#define BATCH_QUERY_H
+
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "components.h"
+#include "csr_graph.h"
+#include "dijkstra.h"
+#include "grid_map.h"
+#include "parallel.h"
+#include "priority_queues.h"
+#include "search_context.h"
+
+struct GridQuery {
+    int startRow, startCol;
+    int goalRow, goalCol;
+};
+
+template <class OpenSet = BinaryHeap>
+class BatchPathfinder {
+public:
+    // The grid must outlive the pathfinder and must not change while a
+    // batch runs. numThreads = 0 uses one worker per core.
+    BatchPathfinder(const GridMap& grid, Connectivity connectivity = Connectivity::Four,
+                    int numThreads = 0)
+        : grid_(&grid), connectivity_(connectivity), pool_(numThreads),
+          components_(grid, pool_.size())
+    {
+        workers_.reserve(pool_.size());
+        for(int i = 0; i < pool_.size(); i++) {
+            workers_.emplace_back(grid);
+        }
+    }
+
+    int numThreads() const { return pool_.size(); }
+
+    // Runs aStarSearch for every query; result i is the path of query i,
+    // empty when the goal cannot be reached. Queries must lie on the grid.
+    std::vector<std::vector<std::pair<int,int>>> run(const std::vector<GridQuery>& queries) {
+        std::vector<std::vector<std::pair<int,int>>> paths(queries.size());
+        pool_.forEachStealing(0, static_cast<int>(queries.size()), [&](int worker, int i) {
+            const GridQuery& q = queries[i];
+            if(!components_.connected(grid_->index(q.startRow, q.startCol),
+                                      grid_->index(q.goalRow, q.goalCol))) return;  // walled off
+            Worker& w = workers_[worker];
+            paths[i] = aStarSearch(*grid_, w.ctx, w.openSet, q.startRow, q.startCol,
+                                   q.goalRow, q.goalCol, connectivity_);
+        }, &stats_);
+        return paths;
+    }
+
+    // One entry per worker for the last run().
+    const std::vector<WorkerStats>& workerStats() const { return stats_; }
+
+    const DynamicGridComponents& components() const { return components_; }
+
+    // Opens or blocks a cell between batches. grid must be the map the
+    // pathfinder was built with; the component labels are updated locally
+    // instead of being rebuilt.
+    void setBlocked(GridMap& grid, int row, int col, bool obstacle) {
+        if(&grid != grid_) {
+            throw std::invalid_argument("BatchPathfinder::setBlocked: not the pathfinder's grid");
+        }
+        components_.setBlocked(grid, row, col, obstacle);
+    }
+
+private:
+    struct Worker {
+        explicit Worker(const GridMap& grid) : ctx(grid) {}
+        SearchContext ctx;
+        OpenSet openSet;
+    };
+
+    const GridMap* grid_;
+    Connectivity connectivity_;
+    WorkerPool pool_;
+    DynamicGridComponents components_;
+    std::vector<Worker> workers_;
+    std::vector<WorkerStats> stats_;
+};
+
+// Point-to-point Dijkstra queries (see PointToPointDijkstra) over a
+// shared CsrGraph and its reverse.
+template <class Queue = BinaryHeap>
+class BatchDijkstra {
+public:
+    // Both graphs must outlive the batch. numThreads = 0 uses one worker
+    // per core.
+    BatchDijkstra(const CsrGraph& graph, const CsrGraph& reverse, int numThreads = 0)
+        : pool_(numThreads), components_(graph, pool_.size())
+    {
+        workers_.reserve(pool_.size());
+        for(int i = 0; i < pool_.size(); i++) {
+            workers_.emplace_back(graph, reverse);
+        }
+    }
+
+    int numThreads() const { return pool_.size(); }
+
+    // Distance i is dist(queries[i].first, queries[i].second), INT_MAX if
+    // unreachable, found by searching from both ends if bidirectional.
+    std::vector<int> run(const std::vector<std::pair<int,int>>& queries, bool bidirectional = false) {
+        std::vector<int> distances(queries.size(), std::numeric_limits<int>::max());
+        pool_.forEachStealing(0, static_cast<int>(queries.size()), [&](int worker, int i) {
+            if(!components_.connected(queries[i].first, queries[i].second)) return;
+            PointToPointDijkstra<Queue>& query = workers_[worker];
+            distances[i] = bidirectional ? query.bidirectionalDistance(queries[i].first, queries[i].second)
+                                         : query.distance(queries[i].first, queries[i].second);
+        }, &stats_);
+        return distances;
+    }
+
+    // One entry per worker for the last run().
+    const std::vector<WorkerStats>& workerStats() const { return stats_; }
+
+    const GraphComponents& components() const { return components_; }
+
+private:
+    WorkerPool pool_;
+    GraphComponents components_;
+    std::vector<PointToPointDijkstra<Queue>> workers_;
+    std::vector<WorkerStats> stats_;
+};
+
+#endif // BATCH_QUERY_H
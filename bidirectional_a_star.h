@@ -0,0 +1,189 @@
+/*******************************************************
+ * Bidirectional A* over a GridMap
+ *
+ * One A* grows from the start and one from the goal, and
+ * they take turns expanding a cell. Each side uses the
+ * consistent average heuristic of Ikeda et al.:
+ *   forward  p(v) = (h(v, goal) - h(start, v)) / 2
+ *   backward      = -p(v)
+ * The two potentials sum to zero, so both searches work on
+ * the same reduced costs and the bidirectional Dijkstra
+ * stopping rule applies unchanged: once the two smallest
+ * keys add up to the best start-goal route found through a
+ * cell both sides have reached, nothing shorter remains.
+ * Keys are doubled to keep them integers, and offset by
+ * h(start, goal) so they never go negative.
+ *
+ * Grid moves are symmetric, so the backward search simply
+ * walks the same grid from the goal. Each side keeps its
+ * own SearchContext and open set; both can be reused.
+ *******************************************************/
+
+#ifndef BIDIRECTIONAL_A_STAR_H
+#define BIDIRECTIONAL_A_STAR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "grid_map.h"
+#include "search_context.h"
+
+// Keys of the two searches for a route from (startRow, startCol) to
+// (goalRow, goalCol): twice the reduced cost from the side's own end,
+// plus h(start, goal). Side 0 searches forward, side 1 backward.
+class BidirectionalGridKeys {
+public:
+    BidirectionalGridKeys(const GridMap& grid, Connectivity connectivity,
+                          int startRow, int startCol, int goalRow, int goalCol)
+        : grid_(&grid), connectivity_(connectivity), startRow_(startRow), startCol_(startCol),
+          goalRow_(goalRow), goalCol_(goalCol),
+          offset_(gridHeuristic(connectivity, startRow, startCol, goalRow, goalCol))
+    {}
+
+    // Key of cell idx reached by side with cost g.
+    int key(int side, int idx, int g) const {
+        int row = grid_->rowOf(idx), col = grid_->colOf(idx);
+        int toGoal = gridHeuristic(connectivity_, row, col, goalRow_, goalCol_);
+        int fromStart = gridHeuristic(connectivity_, startRow_, startCol_, row, col);
+        return 2 * g + offset_ + (side == 0 ? toGoal - fromStart : fromStart - toGoal);
+    }
+
+    // Sum of the two keys at the meeting cell of a route costing cost.
+    // Once the smallest keys of both sides reach it, no cheaper route is
+    // left to find.
+    int64_t bound(int cost) const { return 2 * (static_cast<int64_t>(cost) + offset_); }
+
+private:
+    const GridMap* grid_;
+    Connectivity connectivity_;
+    int startRow_, startCol_, goalRow_, goalCol_;
+    int offset_;
+};
+
+// The moves of aStarSearch as index offsets: forEach(idx, fn) calls
+// fn(neighbourIdx, stepCost) for every free neighbour of idx that can
+// be entered without cutting a corner.
+class GridMoves {
+public:
+    GridMoves(const GridMap& grid, Connectivity connectivity)
+        : grid_(&grid), numDirs_(connectivity == Connectivity::Eight ? 8 : 4),
+          straightCost_(connectivity == Connectivity::Eight ? kStraightCost8 : 1)
+    {
+        const int dRow[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+        const int dCol[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+        for(int i = 0; i < 8; i++) {
+            offsets_[i] = dRow[i] * grid.stride() + dCol[i];
+        }
+    }
+
+    template <class Fn>
+    void forEach(int idx, Fn fn) const {
+        // A diagonal move i >= 4 cuts past the cardinal cells sideA[i] and sideB[i]
+        static const int sideA[8] = {0, 0, 0, 0, 0, 0, 1, 1};
+        static const int sideB[8] = {0, 0, 0, 0, 2, 3, 2, 3};
+        for(int i = 0; i < numDirs_; i++) {
+            int nIdx = idx + offsets_[i];
+            if(grid_->blocked(nIdx)) continue;
+            if(i < 4) {
+                fn(nIdx, straightCost_);
+            } else if(!grid_->blocked(idx + offsets_[sideA[i]]) &&
+                      !grid_->blocked(idx + offsets_[sideB[i]])) {
+                fn(nIdx, kDiagonalCost8);
+            }
+        }
+    }
+
+private:
+    const GridMap* grid_;
+    int numDirs_;
+    int straightCost_;
+    int offsets_[8];
+};
+
+// Cells expanded by each side of the last bidirectional query; their
+// sum compares directly with the cells a plain A* run closes.
+struct BidirectionalStats {
+    int forwardExpansions = 0;
+    int backwardExpansions = 0;
+};
+
+// Bidirectional A*. Returns a path of the same optimal cost as
+// aStarSearch. The two contexts must be distinct and built for this grid.
+template <class OpenSet>
+std::vector<std::pair<int,int>> bidirectionalAStarSearch(const GridMap& grid,
+                                                         SearchContext& forwardCtx,
+                                                         SearchContext& backwardCtx,
+                                                         OpenSet& forwardOpen,
+                                                         OpenSet& backwardOpen,
+                                                         int startRow, int startCol,
+                                                         int goalRow, int goalCol,
+                                                         Connectivity connectivity = Connectivity::Four,
+                                                         BidirectionalStats* stats = nullptr)
+{
+    const int INF = std::numeric_limits<int>::max();
+    SearchContext* ctx[2] = {&forwardCtx, &backwardCtx};
+    OpenSet* openSet[2] = {&forwardOpen, &backwardOpen};
+    int expansions[2] = {0, 0};
+    const int endIdx[2] = {grid.index(startRow, startCol), grid.index(goalRow, goalCol)};
+    const BidirectionalGridKeys keys(grid, connectivity, startRow, startCol, goalRow, goalCol);
+
+    for(int side = 0; side < 2; side++) {
+        ctx[side]->checkGrid(grid);
+        ctx[side]->beginQuery();
+        openSet[side]->reset(grid.size());
+        ctx[side]->update(endIdx[side], 0, -1);
+        openSet[side]->push(keys.key(side, endIdx[side], 0), endIdx[side]);
+    }
+
+    const GridMoves moves(grid, connectivity);
+
+    int best = endIdx[0] == endIdx[1] ? 0 : INF;
+    int meetIdx = endIdx[0] == endIdx[1] ? endIdx[0] : -1;
+    int lastKey[2] = {keys.key(0, endIdx[0], 0), keys.key(1, endIdx[1], 0)};  // never decrease
+    int side = 0;
+    while(best != 0 && !openSet[0]->empty() && !openSet[1]->empty()) {
+        auto [currentKey, currentIdx] = openSet[side]->pop();
+        SearchContext& own = *ctx[side];
+        const SearchContext& other = *ctx[1 - side];
+        if(own.isClosed(currentIdx)) continue;
+        lastKey[side] = currentKey;
+        // Every unseen route has keys summing to at least these two
+        if(best != INF && static_cast<int64_t>(currentKey) + lastKey[1 - side] >= keys.bound(best)) break;
+        own.close(currentIdx);
+        expansions[side]++;
+
+        int gCost = own.g(currentIdx);
+        moves.forEach(currentIdx, [&](int nIdx, int stepCost) {
+            int tentativeGCost = gCost + stepCost;
+            if(!own.isClosed(nIdx) && (!own.visited(nIdx) || tentativeGCost < own.g(nIdx))) {
+                own.update(nIdx, tentativeGCost, currentIdx);
+                openSet[side]->push(keys.key(side, nIdx, tentativeGCost), nIdx);
+            }
+            // A cell the other side has reached joins the two halves
+            if(other.visited(nIdx) && own.g(nIdx) + other.g(nIdx) < best) {
+                best = own.g(nIdx) + other.g(nIdx);
+                meetIdx = nIdx;
+            }
+        });
+        side = 1 - side;
+    }
+
+    if(stats) {
+        stats->forwardExpansions = expansions[0];
+        stats->backwardExpansions = expansions[1];
+    }
+    if(meetIdx == -1) return {};
+
+    // Start -> meeting cell, then the backward parents on to the goal
+    std::vector<std::pair<int,int>> path = tracePath(grid, forwardCtx, meetIdx);
+    for(int idx = backwardCtx.parent(meetIdx); idx != -1; idx = backwardCtx.parent(idx)) {
+        path.push_back({grid.rowOf(idx), grid.colOf(idx)});
+    }
+    return path;
+}
+
+#endif // BIDIRECTIONAL_A_STAR_H
@@ -0,0 +1,144 @@
+/*******************************************************
+ * BitGrid - bit-packed obstacle masks for a GridMap
+ *
+ * One bit per padded cell (1 = blocked, border included),
+ * packed twice:
+ *   rows    - each padded row as a run of 64-bit words
+ *   columns - the transposed grid, each padded column as
+ *             a run of words, for vertical scans
+ * A straight scan then tests 64 cells per word: blocked
+ * cells and forced neighbours become set bits and the
+ * first one is found with count trailing/leading zeros,
+ * so crossing a 1000-cell corridor takes ~16 word steps.
+ *
+ * A BitGrid is a snapshot; rebuild it after editing the
+ * map it was made from.
+ *******************************************************/
+
+#ifndef BIT_GRID_H
+#define BIT_GRID_H
+
+#include <cstdint>
+#include <vector>
+
+#if __cplusplus >= 202002L
+#include <bit>
+#endif
+
+#include "grid_map.h"
+
+// Index of the lowest set bit of a nonzero word.
+inline int lowestBit(uint64_t word) {
+#if __cplusplus >= 202002L
+    return std::countr_zero(word);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while((word & 1) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Index of the highest set bit of a nonzero word.
+inline int highestBit(uint64_t word) {
+#if __cplusplus >= 202002L
+    return 63 - std::countl_zero(word);
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(word);
+#else
+    int bit = 0;
+    while(word >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+class BitGrid {
+public:
+    BitGrid() = default;
+
+    explicit BitGrid(const GridMap& grid)
+        : rows_(grid.rows()), cols_(grid.cols()), stride_(grid.stride()),
+          rowWords_(lineWords(grid.stride())), colWords_(lineWords(grid.rows() + 2)),
+          rowBits_(static_cast<size_t>(grid.rows() + 2) * rowWords_, 0),
+          colBits_(static_cast<size_t>(grid.stride()) * colWords_, 0)
+    {
+        int paddedRows = rows_ + 2;
+        for(int r = 0; r < paddedRows; r++) {
+            for(int c = 0; c < stride_; c++) {
+                if(grid.blocked(r * stride_ + c)) {
+                    rowBits_[static_cast<size_t>(r) * rowWords_ + (c >> 6)] |= uint64_t(1) << (c & 63);
+                    colBits_[static_cast<size_t>(c) * colWords_ + (r >> 6)] |= uint64_t(1) << (r & 63);
+                }
+            }
+        }
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int stride() const { return stride_; }
+
+    bool matches(const GridMap& grid) const {
+        return grid.rows() == rows_ && grid.cols() == cols_;
+    }
+
+    // Bits of padded row r (0 .. rows()+1), bit c = padded column c.
+    const uint64_t* row(int r) const { return rowBits_.data() + static_cast<size_t>(r) * rowWords_; }
+
+    // Bits of padded column c (0 .. stride()-1), bit r = padded row r.
+    const uint64_t* column(int c) const { return colBits_.data() + static_cast<size_t>(c) * colWords_; }
+
+private:
+    // Words per line, plus one zero word so a backward scan can always
+    // read the word after the current one.
+    static int lineWords(int cells) { return (cells + 63) / 64 + 1; }
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int stride_ = 0;
+    int rowWords_ = 0;
+    int colWords_ = 0;
+    std::vector<uint64_t> rowBits_;
+    std::vector<uint64_t> colBits_;
+};
+
+// Scans a line of cells from pos in direction dir (+1 or -1) and returns
+// the first position that is blocked in line, or whose neighbour in
+// sideA/sideB (the parallel lines either side) is free while the cell
+// behind that neighbour is blocked - a forced neighbour in JPS terms.
+// Every line ends in a blocked border cell, so a stop always exists.
+inline int bitScanStraight(const uint64_t* line, const uint64_t* sideA, const uint64_t* sideB,
+                           int pos, int dir)
+{
+    if(dir > 0) {
+        int p = pos + 1;
+        int w = p >> 6;
+        uint64_t mask = ~uint64_t(0) << (p & 63);
+        for(;; w++, mask = ~uint64_t(0)) {
+            uint64_t a = sideA[w], b = sideB[w];
+            uint64_t carryA = w > 0 ? sideA[w - 1] >> 63 : 0;
+            uint64_t carryB = w > 0 ? sideB[w - 1] >> 63 : 0;
+            uint64_t stop = line[w] | (~a & ((a << 1) | carryA)) | (~b & ((b << 1) | carryB));
+            stop &= mask;
+            if(stop != 0) return (w << 6) + lowestBit(stop);
+        }
+    }
+    int p = pos - 1;
+    int w = p >> 6;
+    uint64_t mask = ~uint64_t(0) >> (63 - (p & 63));
+    for(;; w--, mask = ~uint64_t(0)) {
+        uint64_t a = sideA[w], b = sideB[w];
+        uint64_t carryA = sideA[w + 1] << 63;
+        uint64_t carryB = sideB[w + 1] << 63;
+        uint64_t stop = line[w] | (~a & ((a >> 1) | carryA)) | (~b & ((b >> 1) | carryB));
+        stop &= mask;
+        if(stop != 0) return (w << 6) + highestBit(stop);
+    }
+}
+
+#endif // BIT_GRID_H
@@ -0,0 +1,55 @@
+/*******************************************************
+ * Checksum - 64-bit fingerprint of in-memory data
+ *
+ * Tables derived from a map or graph (JPS+ jump distances,
+ * ALT landmark distances) are saved next to their input
+ * and memory-mapped back later. They are only correct for
+ * the exact input they were built from, so their files
+ * record its checksum and loaders compare it.
+ *
+ * Data is consumed a 64-bit word at a time, FNV-1a style
+ * with an extra xor-shift so high bits feed back into low
+ * ones. Every step is a bijection of the state, so any
+ * single changed word always changes the result; it is
+ * not meant to resist deliberate collisions.
+ *******************************************************/
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class Checksum {
+public:
+    void add(uint64_t word) {
+        hash_ = (hash_ ^ word) * kPrime;
+        hash_ ^= hash_ >> 29;
+    }
+
+    // Adds the byte count, then the bytes as words in host byte order; a
+    // short tail is padded with zeros.
+    void add(const void* data, size_t bytes) {
+        auto p = static_cast<const uint8_t*>(data);
+        add(static_cast<uint64_t>(bytes));
+        for(; bytes >= 8; p += 8, bytes -= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            add(word);
+        }
+        if(bytes > 0) {
+            uint64_t word = 0;
+            std::memcpy(&word, p, bytes);
+            add(word);
+        }
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    static const uint64_t kPrime = 0x100000001b3ull;
+    uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+#endif // CHECKSUM_H
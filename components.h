@@ -0,0 +1,385 @@
+/*******************************************************
+ * Connected components for instant unreachable checks
+ *
+ * A query whose goal is walled off explores everything the
+ * start can reach before it gives up, which makes failed
+ * queries the slowest ones. Labelling the components once
+ * turns them into a single comparison.
+ *
+ * Labels are found with a concurrent union-find: every
+ * thread unites the endpoints of its share of the edges,
+ * and roots are linked by compare-and-swap, always the
+ * larger index under the smaller. Parents therefore only
+ * ever point to smaller indices, so no cycle can form, and
+ * finds halve their paths with CAS as they go. The label
+ * of a vertex is its final root.
+ *
+ * GridComponents labels the free cells of a GridMap. A
+ * diagonal move is only allowed when both cells it cuts
+ * past are free, so it never joins cells that were not
+ * already 4-connected; one labelling serves both
+ * connectivities. GraphComponents labels a CsrGraph. On a
+ * directed graph these are the weakly connected components:
+ * different labels still prove that no path exists, but
+ * equal labels do not promise one.
+ *
+ * DynamicGridComponents keeps grid labels current while
+ * cells are opened and blocked. Labels are plain component
+ * ids, so the check stays a single comparison:
+ *   opening a cell joins the components around it, and the
+ *     smaller ones are relabelled into the largest;
+ *   blocking a cell may split its component. Breadth-first
+ *     searches start from each free neighbour and take
+ *     turns; searches that meet are merged. If all merge,
+ *     nothing split, usually after a few steps around the
+ *     cell. If a merged group runs out of cells, it is a
+ *     piece that broke off and gets a new id.
+ *     The largest piece is never walked in full, so the
+ *     cost is about that of the smaller pieces.
+ *******************************************************/
+
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "grid_map.h"
+#include "parallel.h"
+
+// Union-find over [0, n) that many threads may use at once.
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(int n)
+        : parent_(new std::atomic<int>[n])
+    {
+        for(int v = 0; v < n; v++) parent_[v].store(v, std::memory_order_relaxed);
+    }
+
+    int find(int v) {
+        for(;;) {
+            int p = parent_[v].load(std::memory_order_relaxed);
+            if(p == v) return v;
+            int grandparent = parent_[p].load(std::memory_order_relaxed);
+            if(grandparent != p) {
+                parent_[v].compare_exchange_weak(p, grandparent, std::memory_order_relaxed);
+            }
+            v = grandparent;
+        }
+    }
+
+    void unite(int a, int b) {
+        for(;;) {
+            a = find(a);
+            b = find(b);
+            if(a == b) return;
+            if(a < b) std::swap(a, b);
+            int expected = a;
+            if(parent_[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+        }
+    }
+
+private:
+    std::unique_ptr<std::atomic<int>[]> parent_;
+};
+
+// Component labels of the free cells of a grid, by flat cell index.
+class GridComponents {
+public:
+    GridComponents() = default;
+
+    // Labels the grid using numThreads threads (0 = one per core).
+    explicit GridComponents(const GridMap& grid, int numThreads = 0)
+        : rows_(grid.rows()), cols_(grid.cols()), label_(grid.size(), -1)
+    {
+        ConcurrentUnionFind sets(grid.size());
+        // The border is blocked, so every free cell has a right and a lower neighbour
+        parallelFor(0, rows_, [&](int r) {
+            for(int c = 0; c < cols_; c++) {
+                int idx = grid.index(r, c);
+                if(grid.blocked(idx)) continue;
+                if(!grid.blocked(idx + 1)) sets.unite(idx, idx + 1);
+                if(!grid.blocked(idx + grid.stride())) sets.unite(idx, idx + grid.stride());
+            }
+        }, numThreads);
+
+        std::atomic<int> roots(0);
+        parallelFor(0, rows_, [&](int r) {
+            int found = 0;
+            for(int c = 0; c < cols_; c++) {
+                int idx = grid.index(r, c);
+                if(grid.blocked(idx)) continue;
+                label_[idx] = sets.find(idx);
+                found += label_[idx] == idx;
+            }
+            roots += found;
+        }, numThreads);
+        numComponents_ = roots.load();
+    }
+
+    bool matches(const GridMap& grid) const {
+        return grid.rows() == rows_ && grid.cols() == cols_;
+    }
+
+    int numComponents() const { return numComponents_; }
+
+    // Label of cell idx; -1 for blocked cells.
+    int component(int idx) const { return label_[idx]; }
+
+    // False if no path can join the two cells.
+    bool connected(int idx1, int idx2) const {
+        return label_[idx1] != -1 && label_[idx1] == label_[idx2];
+    }
+
+private:
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<int> label_;
+    int numComponents_ = 0;
+};
+
+// Component labels of the vertices of a CsrGraph (weak components if it
+// is directed).
+class GraphComponents {
+public:
+    GraphComponents() = default;
+
+    // Labels the graph using numThreads threads (0 = one per core).
+    explicit GraphComponents(const CsrGraph& graph, int numThreads = 0)
+        : label_(graph.numVertices())
+    {
+        int n = graph.numVertices();
+        ConcurrentUnionFind sets(n);
+        parallelFor(0, n, [&](int u) {
+            for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+                sets.unite(u, graph.target(e));
+            }
+        }, numThreads);
+
+        std::atomic<int> roots(0);
+        parallelFor(0, n, [&](int v) {
+            label_[v] = sets.find(v);
+            if(label_[v] == v) roots++;
+        }, numThreads);
+        numComponents_ = roots.load();
+    }
+
+    int numVertices() const { return static_cast<int>(label_.size()); }
+    int numComponents() const { return numComponents_; }
+    int component(int v) const { return label_[v]; }
+
+    // False if no path can lead from s to t.
+    bool connected(int s, int t) const { return label_[s] == label_[t]; }
+
+private:
+    std::vector<int> label_;
+    int numComponents_ = 0;
+};
+
+// Grid component labels that follow edits to the map. Edits must go
+// through setBlocked() so the labels see them.
+class DynamicGridComponents {
+public:
+    DynamicGridComponents() = default;
+
+    // Labels the grid from scratch using numThreads threads (0 = one per core).
+    explicit DynamicGridComponents(const GridMap& grid, int numThreads = 0)
+        : stride_(grid.stride()), rows_(grid.rows()), cols_(grid.cols()),
+          label_(grid.size(), -1), mark_(grid.size(), 0)
+    {
+        // Renumber the union-find roots as dense ids so sizes fit a vector
+        GridComponents initial(grid, numThreads);
+        std::vector<int> idOfRoot(grid.size(), -1);
+        for(int idx = 0; idx < grid.size(); idx++) {
+            int root = initial.component(idx);
+            if(root == -1) continue;
+            if(idOfRoot[root] == -1) idOfRoot[root] = allocateId();
+            label_[idx] = idOfRoot[root];
+            size_[label_[idx]]++;
+        }
+    }
+
+    bool matches(const GridMap& grid) const {
+        return grid.rows() == rows_ && grid.cols() == cols_;
+    }
+
+    int numComponents() const { return numComponents_; }
+
+    // Label of cell idx; -1 for blocked cells.
+    int component(int idx) const { return label_[idx]; }
+
+    // Number of free cells in component id.
+    int componentSize(int id) const { return size_[id]; }
+
+    // False if no path can join the two cells.
+    bool connected(int idx1, int idx2) const {
+        return label_[idx1] != -1 && label_[idx1] == label_[idx2];
+    }
+
+    // Sets the cell in grid (the map these labels were built for) and
+    // updates the labels to match.
+    void setBlocked(GridMap& grid, int row, int col, bool obstacle) {
+        if(!matches(grid)) {
+            throw std::invalid_argument("DynamicGridComponents does not match grid");
+        }
+        int idx = grid.index(row, col);
+        if(grid.blocked(idx) == obstacle) return;
+        grid.setBlocked(row, col, obstacle);
+        if(obstacle) {
+            block(grid, idx);
+        } else {
+            open(idx);
+        }
+    }
+
+private:
+    int allocateId() {
+        numComponents_++;
+        if(!freeIds_.empty()) {
+            int id = freeIds_.back();
+            freeIds_.pop_back();
+            size_[id] = 0;
+            return id;
+        }
+        size_.push_back(0);
+        return static_cast<int>(size_.size()) - 1;
+    }
+
+    void releaseId(int id) {
+        numComponents_--;
+        freeIds_.push_back(id);
+    }
+
+    int neighbour(int idx, int dir) const {
+        const int offsets[4] = {-stride_, stride_, -1, 1};
+        return idx + offsets[dir];
+    }
+
+    void open(int idx) {
+        // The largest neighbouring component absorbs the others
+        int survivor = -1;
+        for(int dir = 0; dir < 4; dir++) {
+            int id = label_[neighbour(idx, dir)];
+            if(id != -1 && (survivor == -1 || size_[id] > size_[survivor])) survivor = id;
+        }
+        if(survivor == -1) survivor = allocateId();
+        for(int dir = 0; dir < 4; dir++) {
+            int start = neighbour(idx, dir);
+            int id = label_[start];
+            if(id == -1 || id == survivor) continue;
+            size_[survivor] += size_[id];
+            releaseId(id);
+            stack_.assign(1, start);
+            label_[start] = survivor;
+            while(!stack_.empty()) {
+                int x = stack_.back();
+                stack_.pop_back();
+                for(int d = 0; d < 4; d++) {
+                    int y = neighbour(x, d);
+                    if(label_[y] == id) {
+                        label_[y] = survivor;
+                        stack_.push_back(y);
+                    }
+                }
+            }
+        }
+        label_[idx] = survivor;
+        size_[survivor]++;
+    }
+
+    void block(const GridMap& grid, int idx) {
+        int id = label_[idx];
+        label_[idx] = -1;
+        size_[id]--;
+
+        int starts[4];
+        int k = 0;
+        for(int dir = 0; dir < 4; dir++) {
+            int nIdx = neighbour(idx, dir);
+            if(!grid.blocked(nIdx)) starts[k++] = nIdx;
+        }
+        if(k == 0) releaseId(id);
+        if(k <= 1) return;
+
+        // One search per free neighbour; mark_ holds epoch << 2 | search
+        if(++epoch_ >= (1u << 30)) {
+            std::fill(mark_.begin(), mark_.end(), 0);
+            epoch_ = 1;
+        }
+        int group[4];
+        size_t head[4];
+        bool done[4] = {false, false, false, false};
+        for(int i = 0; i < k; i++) {
+            group[i] = i;
+            head[i] = 0;
+            searches_[i].assign(1, starts[i]);
+            mark_[starts[i]] = epoch_ << 2 | i;
+        }
+        auto groupOf = [&](int i) {
+            while(group[i] != i) i = group[i];
+            return i;
+        };
+
+        int groups = k;
+        while(groups > 1) {
+            for(int i = 0; i < k && groups > 1; i++) {
+                if(done[i] || head[i] == searches_[i].size()) continue;
+                int x = searches_[i][head[i]++];
+                for(int d = 0; d < 4 && groups > 1; d++) {
+                    int y = neighbour(x, d);
+                    if(grid.blocked(y)) continue;
+                    if((mark_[y] >> 2) != epoch_) {
+                        mark_[y] = epoch_ << 2 | i;
+                        searches_[i].push_back(y);
+                    } else {
+                        int a = groupOf(i), b = groupOf(static_cast<int>(mark_[y] & 3));
+                        if(a != b) {
+                            group[std::max(a, b)] = std::min(a, b);
+                            groups--;
+                        }
+                    }
+                }
+            }
+            if(groups == 1) break;
+
+            // A group with no cells left to expand is a piece that broke off
+            for(int g = 0; g < k && groups > 1; g++) {
+                if(done[g] || groupOf(g) != g) continue;
+                bool exhausted = true;
+                for(int i = 0; i < k; i++) {
+                    if(groupOf(i) == g && head[i] != searches_[i].size()) exhausted = false;
+                }
+                if(!exhausted) continue;
+                int piece = allocateId();
+                for(int i = 0; i < k; i++) {
+                    if(groupOf(i) != g) continue;
+                    done[i] = true;
+                    for(int x : searches_[i]) label_[x] = piece;
+                    size_[piece] += static_cast<int>(searches_[i].size());
+                }
+                size_[id] -= size_[piece];
+                groups--;
+            }
+        }
+    }
+
+    int stride_ = 0;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<int> label_;
+    std::vector<int> size_;      // free cells per id
+    std::vector<int> freeIds_;
+    int numComponents_ = 0;
+    std::vector<uint32_t> mark_;
+    uint32_t epoch_ = 0;
+    std::vector<int> searches_[4];
+    std::vector<int> stack_;
+};
+
+#endif // COMPONENTS_H
@@ -0,0 +1,483 @@
+/*******************************************************
+ * Contraction Hierarchies for repeated point-to-point
+ * queries on a CsrGraph
+ *
+ * Preprocessing contracts the vertices one at a time in
+ * order of importance. Contracting v removes it from the
+ * remaining graph; for each pair of remaining neighbours
+ * u -> v -> x whose shortest path runs through v, a
+ * shortcut u -> x is added. A local "witness" Dijkstra
+ * from u that avoids v decides whether some other path is
+ * as short, in which case no shortcut is needed. The next
+ * vertex to contract is the one with the smallest
+ * 2 x edge difference (shortcuts added - edges removed)
+ * plus its number of already contracted neighbours, which
+ * spreads contraction evenly over the graph.
+ *
+ * Every edge then leads up the hierarchy from one end, so
+ * a query runs Dijkstra upwards from the source and
+ * upwards (against edge direction) from the target. The
+ * two searches meet at the highest vertex of a shortest
+ * path; they settle a few hundred vertices instead of most
+ * of the graph and return the same distances as dijkstra().
+ *******************************************************/
+
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+#include "priority_queues.h"
+
+// The contracted graph: vertex ranks plus the upward edges of each
+// vertex. forward holds u -> v with rank v > rank u; backward holds, at
+// v, every edge u -> v with rank u > rank v, stored as v -> u.
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() = default;
+
+    ContractionHierarchy(std::vector<int> rank, CsrGraph forward, CsrGraph backward, int64_t shortcuts)
+        : rank_(std::move(rank)), forward_(std::move(forward)), backward_(std::move(backward)),
+          shortcuts_(shortcuts)
+    {
+        if(forward_.numVertices() != static_cast<int>(rank_.size()) ||
+           backward_.numVertices() != static_cast<int>(rank_.size())) {
+            throw std::invalid_argument("ContractionHierarchy: inconsistent vertex counts");
+        }
+    }
+
+    int numVertices() const { return static_cast<int>(rank_.size()); }
+    int rank(int v) const { return rank_[v]; }
+    const CsrGraph& forward() const { return forward_; }
+    const CsrGraph& backward() const { return backward_; }
+
+    // Shortcut edges added during preprocessing.
+    int64_t numShortcuts() const { return shortcuts_; }
+
+private:
+    std::vector<int> rank_;
+    CsrGraph forward_;
+    CsrGraph backward_;
+    int64_t shortcuts_ = 0;
+};
+
+// Witness searches give up after settling this many vertices and add the
+// shortcut; this only costs a few redundant shortcuts. Priorities are
+// estimates anyway, so their simulated contractions search less.
+const int kChWitnessSettleLimit = 500;
+const int kChPrioritySettleLimit = 50;
+
+struct ChArc {
+    int node;
+    int weight;
+};
+
+// Bounded Dijkstra over the remaining graph used by the witness searches.
+// Distances are stamped per search so each run starts in O(1).
+class ChWitnessSearch {
+public:
+    explicit ChWitnessSearch(int n) : dist_(n, 0), stamp_(n, 0), targetStamp_(n, 0) {}
+
+    // Distances from source in out, skipping vertex avoid and any vertex
+    // flagged in excluded (if given). Stops once
+    // every vertex in targets is settled, the next vertex is farther than
+    // maxCost, or settleLimit vertices have been settled.
+    void run(const std::vector<std::vector<ChArc>>& out, int source, int avoid,
+             const std::vector<char>* excluded, const std::vector<ChArc>& targets, int maxCost,
+             int settleLimit = kChWitnessSettleLimit) {
+        if(++current_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            std::fill(targetStamp_.begin(), targetStamp_.end(), 0);
+            current_ = 1;
+        }
+        int remaining = 0;
+        for(const ChArc& target : targets) {
+            if(targetStamp_[target.node] != current_) {
+                targetStamp_[target.node] = current_;
+                remaining++;
+            }
+        }
+        heap_.reset(static_cast<int>(dist_.size()));
+        set(source, 0);
+        heap_.push(0, source);
+        int settled = 0;
+        while(!heap_.empty()) {
+            auto [d, u] = heap_.pop();
+            if(d > dist_[u]) continue;
+            if(d > maxCost || ++settled > settleLimit) break;
+            if(targetStamp_[u] == current_ && --remaining == 0) break;
+            for(const ChArc& arc : out[u]) {
+                if(arc.node == avoid || (excluded && (*excluded)[arc.node])) continue;
+                int nd = d + arc.weight;
+                if(nd < distance(arc.node)) {
+                    set(arc.node, nd);
+                    heap_.push(nd, arc.node);
+                }
+            }
+        }
+    }
+
+    // Upper bound from the last run (INT_MAX if not reached).
+    int distance(int v) const {
+        return stamp_[v] == current_ ? dist_[v] : std::numeric_limits<int>::max();
+    }
+
+private:
+    void set(int v, int d) {
+        dist_[v] = d;
+        stamp_[v] = current_;
+    }
+
+    std::vector<int> dist_;
+    std::vector<uint32_t> stamp_;
+    std::vector<uint32_t> targetStamp_;
+    uint32_t current_ = 0;
+    BinaryHeap heap_;
+};
+
+// Incremental contraction state: the remaining graph as mutable in/out
+// adjacency lists, plus the upward edges recorded so far.
+class ChContractor {
+public:
+    explicit ChContractor(const CsrGraph& graph)
+        : n_(graph.numVertices()), out_(n_), in_(n_), up_(n_), down_(n_),
+          contracted_(n_, 0), contractedNeighbors_(n_, 0), rank_(n_, -1)
+    {
+        for(int u = 0; u < n_; u++) {
+            for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+                int v = graph.target(e);
+                if(v != u) addArc(u, v, graph.weight(e));
+            }
+        }
+    }
+
+    int numVertices() const { return n_; }
+    bool contracted(int v) const { return contracted_[v] != 0; }
+    int64_t numShortcuts() const { return shortcuts_; }
+
+    // Importance of v if it were contracted now; lower goes first.
+    int priority(int v, ChWitnessSearch& search) const {
+        int shortcuts = 0;
+        forEachShortcut(v, search, kChPrioritySettleLimit, nullptr, [&](int, int, int) { shortcuts++; });
+        int edgeDifference = shortcuts - static_cast<int>(in_[v].size() + out_[v].size());
+        return 2 * edgeDifference + contractedNeighbors_[v];
+    }
+
+    // Shortcuts contracting v would need, as (from, to, weight). Witness
+    // paths may not use vertices flagged in excluded, so vertices that are
+    // contracted together cannot serve as each other's witnesses.
+    void shortcuts(int v, ChWitnessSearch& search, std::vector<std::pair<std::pair<int,int>,int>>& out,
+                   const std::vector<char>* excluded = nullptr) const {
+        out.clear();
+        forEachShortcut(v, search, kChWitnessSettleLimit, excluded,
+                        [&](int u, int x, int w) { out.push_back({{u, x}, w}); });
+    }
+
+    // Removes v from the remaining graph and gives it the next rank. Its
+    // remaining edges become upward edges of the hierarchy.
+    void contract(int v, int rank, const std::vector<std::pair<std::pair<int,int>,int>>& shortcuts) {
+        for(const ChArc& arc : out_[v]) {
+            up_[v].push_back(arc);
+            removeArc(in_[arc.node], v);
+            contractedNeighbors_[arc.node]++;
+        }
+        for(const ChArc& arc : in_[v]) {
+            down_[v].push_back(arc);
+            removeArc(out_[arc.node], v);
+            contractedNeighbors_[arc.node]++;
+        }
+        for(const auto& s : shortcuts) {
+            addArc(s.first.first, s.first.second, s.second);
+        }
+        shortcuts_ += static_cast<int64_t>(shortcuts.size());
+        out_[v].clear();
+        in_[v].clear();
+        out_[v].shrink_to_fit();
+        in_[v].shrink_to_fit();
+        contracted_[v] = 1;
+        rank_[v] = rank;
+    }
+
+    // Remaining neighbours of v, in either direction (may repeat).
+    template <class Fn>
+    void forEachNeighbor(int v, Fn fn) const {
+        for(const ChArc& arc : out_[v]) fn(arc.node);
+        for(const ChArc& arc : in_[v]) fn(arc.node);
+    }
+
+    // Packs the result once every vertex is contracted.
+    ContractionHierarchy finish() {
+        return ContractionHierarchy(std::move(rank_), pack(up_), pack(down_), shortcuts_);
+    }
+
+private:
+    template <class Fn>
+    void forEachShortcut(int v, ChWitnessSearch& search, int settleLimit,
+                         const std::vector<char>* excluded, Fn fn) const {
+        int maxOut = 0;
+        for(const ChArc& arc : out_[v]) maxOut = std::max(maxOut, arc.weight);
+        for(const ChArc& in : in_[v]) {
+            search.run(out_, in.node, v, excluded, out_[v], in.weight + maxOut, settleLimit);
+            for(const ChArc& arc : out_[v]) {
+                if(arc.node == in.node) continue;
+                int viaV = in.weight + arc.weight;
+                if(search.distance(arc.node) > viaV) {
+                    fn(in.node, arc.node, viaV);
+                }
+            }
+        }
+    }
+
+    // Adds u -> v, keeping only the lighter of parallel edges.
+    void addArc(int u, int v, int w) {
+        for(ChArc& arc : out_[u]) {
+            if(arc.node == v) {
+                if(w < arc.weight) {
+                    arc.weight = w;
+                    for(ChArc& back : in_[v]) {
+                        if(back.node == u) back.weight = w;
+                    }
+                }
+                return;
+            }
+        }
+        out_[u].push_back({v, w});
+        in_[v].push_back({u, w});
+    }
+
+    static void removeArc(std::vector<ChArc>& arcs, int node) {
+        for(size_t i = 0; i < arcs.size(); i++) {
+            if(arcs[i].node == node) {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    }
+
+    CsrGraph pack(const std::vector<std::vector<ChArc>>& lists) const {
+        CsrGraphBuilder builder(n_);
+        for(int u = 0; u < n_; u++) {
+            for(const ChArc& arc : lists[u]) builder.addEdge(u, arc.node, arc.weight);
+        }
+        return builder.build();
+    }
+
+    int n_;
+    std::vector<std::vector<ChArc>> out_;
+    std::vector<std::vector<ChArc>> in_;
+    std::vector<std::vector<ChArc>> up_;    // upward edges by source
+    std::vector<std::vector<ChArc>> down_;  // upward edges by target, reversed
+    std::vector<char> contracted_;
+    std::vector<int> contractedNeighbors_;
+    std::vector<int> rank_;
+    int64_t shortcuts_ = 0;
+};
+
+// Builds the hierarchy by contracting one vertex at a time, always the
+// one with the lowest priority. Priorities are refreshed lazily when a
+// vertex reaches the front and after each of its neighbours contracts.
+inline ContractionHierarchy buildContractionHierarchy(const CsrGraph& graph) {
+    ChContractor contractor(graph);
+    int n = contractor.numVertices();
+    ChWitnessSearch search(n);
+
+    std::vector<int> priority(n);
+    std::priority_queue<std::pair<int,int>, std::vector<std::pair<int,int>>,
+                        std::greater<std::pair<int,int>>> queue;
+    for(int v = 0; v < n; v++) {
+        priority[v] = contractor.priority(v, search);
+        queue.push({priority[v], v});
+    }
+
+    std::vector<std::pair<std::pair<int,int>,int>> shortcuts;
+    std::vector<int> neighbors;
+    int rank = 0;
+    while(!queue.empty()) {
+        auto [p, v] = queue.top();
+        queue.pop();
+        if(contractor.contracted(v) || p != priority[v]) continue;
+
+        int current = contractor.priority(v, search);
+        if(!queue.empty() && current > queue.top().first) {
+            priority[v] = current;
+            queue.push({current, v});
+            continue;
+        }
+
+        neighbors.clear();
+        contractor.forEachNeighbor(v, [&](int u) { neighbors.push_back(u); });
+        contractor.shortcuts(v, search, shortcuts);
+        contractor.contract(v, rank++, shortcuts);
+
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        for(int u : neighbors) {
+            priority[u] = contractor.priority(u, search);
+            queue.push({priority[u], u});
+        }
+    }
+    return contractor.finish();
+}
+
+// Parallel build. Each round contracts an independent set of vertices -
+// those whose priority beats every remaining neighbour's - across
+// numThreads threads (0 = all cores), each with its own witness search
+// state. Witness searches skip the whole set, so the shortcuts of a
+// round do not depend on each other and are applied afterwards.
+// Queries give the same distances as with the sequential build.
+inline ContractionHierarchy buildContractionHierarchyParallel(const CsrGraph& graph, int numThreads = 0) {
+    if(numThreads <= 0) numThreads = defaultThreadCount();
+    ChContractor contractor(graph);
+    int n = contractor.numVertices();
+    std::vector<ChWitnessSearch> searches(numThreads, ChWitnessSearch(n));
+
+    std::vector<int> remaining(n);
+    for(int v = 0; v < n; v++) remaining[v] = v;
+    std::vector<int> priority(n);
+    parallelForWorkers(0, n, numThreads, [&](int worker, int v) {
+        priority[v] = contractor.priority(v, searches[worker]);
+    });
+
+    // Ties go to a scrambled vertex id so sets stay spread out
+    auto before = [&](int a, int b) {
+        if(priority[a] != priority[b]) return priority[a] < priority[b];
+        uint32_t ha = static_cast<uint32_t>(a) * 2654435761u, hb = static_cast<uint32_t>(b) * 2654435761u;
+        return ha != hb ? ha < hb : a < b;
+    };
+
+    std::vector<char> inSet(n, 0);
+    std::vector<int> set, touched;
+    std::vector<std::vector<std::pair<std::pair<int,int>,int>>> shortcuts;
+    int rank = 0;
+    while(!remaining.empty()) {
+        int count = static_cast<int>(remaining.size());
+        parallelFor(0, count, [&](int i) {
+            int v = remaining[i];
+            bool smallest = true;
+            contractor.forEachNeighbor(v, [&](int u) {
+                if(u != v && !before(v, u)) smallest = false;
+            });
+            inSet[v] = smallest ? 1 : 0;
+        }, numThreads);
+
+        set.clear();
+        for(int v : remaining) {
+            if(inSet[v]) set.push_back(v);
+        }
+
+        shortcuts.resize(set.size());
+        parallelForWorkers(0, static_cast<int>(set.size()), numThreads, [&](int worker, int i) {
+            contractor.shortcuts(set[i], searches[worker], shortcuts[i], &inSet);
+        });
+
+        touched.clear();
+        for(size_t i = 0; i < set.size(); i++) {
+            contractor.forEachNeighbor(set[i], [&](int u) { touched.push_back(u); });
+            contractor.contract(set[i], rank++, shortcuts[i]);
+        }
+        for(int v : set) inSet[v] = 0;
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        parallelForWorkers(0, static_cast<int>(touched.size()), numThreads, [&](int worker, int i) {
+            priority[touched[i]] = contractor.priority(touched[i], searches[worker]);
+        });
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [&](int v) { return contractor.contracted(v); }),
+                        remaining.end());
+    }
+    return contractor.finish();
+}
+
+// Point-to-point queries on a ContractionHierarchy. Holds the per-vertex
+// search state, so create one per thread and reuse it across queries.
+class ChQuery {
+public:
+    explicit ChQuery(const ContractionHierarchy& ch)
+        : ch_(&ch), dist_{std::vector<int>(ch.numVertices()), std::vector<int>(ch.numVertices())},
+          stamp_{std::vector<uint32_t>(ch.numVertices(), 0), std::vector<uint32_t>(ch.numVertices(), 0)}
+    {}
+
+    // Shortest distance from source to target, or INT_MAX if unreachable.
+    int distance(int source, int target) {
+        const int INF = std::numeric_limits<int>::max();
+        if(++current_ == 0) {
+            for(auto& stamps : stamp_) std::fill(stamps.begin(), stamps.end(), 0);
+            current_ = 1;
+        }
+        settled_ = 0;
+
+        const CsrGraph* graphs[2] = {&ch_->forward(), &ch_->backward()};
+        int best = INF;
+        for(int side = 0; side < 2; side++) heap_[side].reset(ch_->numVertices());
+        set(0, source, 0);
+        set(1, target, 0);
+        heap_[0].push(0, source);
+        heap_[1].push(0, target);
+
+        // Alternate sides; a side stops once its next key cannot beat best
+        bool done[2] = {false, false};
+        while(!done[0] || !done[1]) {
+            for(int side = 0; side < 2; side++) {
+                if(done[side]) continue;
+                if(heap_[side].empty()) {
+                    done[side] = true;
+                    continue;
+                }
+                auto [d, u] = heap_[side].pop();
+                if(d > get(side, u)) continue;
+                if(d >= best) {
+                    done[side] = true;
+                    continue;
+                }
+                settled_++;
+                int other = get(1 - side, u);
+                if(other != INF && d + other < best) best = d + other;
+
+                const CsrGraph& g = *graphs[side];
+                for(int64_t e = g.edgeBegin(u); e < g.edgeEnd(u); e++) {
+                    int v = g.target(e);
+                    int nd = d + g.weight(e);
+                    if(nd < get(side, v)) {
+                        set(side, v, nd);
+                        heap_[side].push(nd, v);
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    // Vertices settled by the last query, both directions together.
+    int settled() const { return settled_; }
+
+private:
+    int get(int side, int v) const {
+        return stamp_[side][v] == current_ ? dist_[side][v] : std::numeric_limits<int>::max();
+    }
+
+    void set(int side, int v, int d) {
+        dist_[side][v] = d;
+        stamp_[side][v] = current_;
+    }
+
+    const ContractionHierarchy* ch_;
+    std::vector<int> dist_[2];
+    std::vector<uint32_t> stamp_[2];
+    uint32_t current_ = 0;
+    BinaryHeap heap_[2];
+    int settled_ = 0;
+};
+
+#endif // CONTRACTION_HIERARCHY_H
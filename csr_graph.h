@@ -0,0 +1,167 @@
+/*******************************************************
+ * CsrGraph - compressed sparse row graph for dijkstra
+ *
+ * The out-edges of vertex u occupy the half-open range
+ * [offsets[u], offsets[u + 1]) of two packed arrays:
+ *   targets[e] - head vertex of edge e
+ *   weights[e] - non-negative weight of edge e
+ * Three flat arrays replace one heap allocation per vertex,
+ * and a vertex's edges are contiguous in memory. A graph
+ * either owns its arrays or views memory kept alive by a
+ * shared owner (see graph_file.h); copies are cheap and
+ * share the same read-only arrays.
+ *******************************************************/
+
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "checksum.h"
+
+class CsrGraph {
+public:
+    CsrGraph() : CsrGraph(std::vector<int64_t>(1, 0), {}, {}) {}
+
+    // Takes ownership of the three arrays.
+    CsrGraph(std::vector<int64_t> offsets, std::vector<int> targets, std::vector<int> weights) {
+        auto storage = std::make_shared<Storage>();
+        storage->offsets = std::move(offsets);
+        storage->targets = std::move(targets);
+        storage->weights = std::move(weights);
+        if(storage->offsets.empty() || storage->targets.size() != storage->weights.size() ||
+           storage->offsets.back() != static_cast<int64_t>(storage->targets.size())) {
+            throw std::invalid_argument("CsrGraph: inconsistent arrays");
+        }
+        n_ = static_cast<int>(storage->offsets.size()) - 1;
+        m_ = static_cast<int64_t>(storage->targets.size());
+        offsets_ = storage->offsets.data();
+        targets_ = storage->targets.data();
+        weights_ = storage->weights.data();
+        owner_ = std::move(storage);
+    }
+
+    // Views arrays that live elsewhere (e.g. a memory-mapped file);
+    // owner keeps that memory alive for as long as any copy of the graph.
+    CsrGraph(int n, int64_t m, const int64_t* offsets, const int* targets,
+             const int* weights, std::shared_ptr<const void> owner)
+        : n_(n), m_(m), offsets_(offsets), targets_(targets), weights_(weights),
+          owner_(std::move(owner))
+    {}
+
+    int numVertices() const { return n_; }
+    int64_t numEdges() const { return m_; }
+
+    // Out-edges of u are the edge ids in [edgeBegin(u), edgeEnd(u)).
+    int64_t edgeBegin(int u) const { return offsets_[u]; }
+    int64_t edgeEnd(int u) const { return offsets_[u + 1]; }
+    int degree(int u) const { return static_cast<int>(offsets_[u + 1] - offsets_[u]); }
+
+    int target(int64_t e) const { return targets_[e]; }
+    int weight(int64_t e) const { return weights_[e]; }
+
+    // Raw arrays: numVertices() + 1 offsets, numEdges() targets/weights.
+    const int64_t* offsets() const { return offsets_; }
+    const int* targets() const { return targets_; }
+    const int* weights() const { return weights_; }
+
+private:
+    struct Storage {
+        std::vector<int64_t> offsets;
+        std::vector<int> targets;
+        std::vector<int> weights;
+    };
+
+    int n_ = 0;
+    int64_t m_ = 0;
+    const int64_t* offsets_ = nullptr;
+    const int* targets_ = nullptr;
+    const int* weights_ = nullptr;
+    std::shared_ptr<const void> owner_;
+};
+
+// Collects directed edges and packs them into a CsrGraph with a counting
+// sort. Edges keep their insertion order within each source vertex.
+class CsrGraphBuilder {
+public:
+    explicit CsrGraphBuilder(int n) : n_(n) {
+        if(n < 0) {
+            throw std::invalid_argument("CsrGraphBuilder: negative vertex count");
+        }
+    }
+
+    void reserve(size_t edges) {
+        sources_.reserve(edges);
+        targets_.reserve(edges);
+        weights_.reserve(edges);
+    }
+
+    // Adds the directed edge u -> v. For undirected graphs add both ways.
+    void addEdge(int u, int v, int w) {
+        if(u < 0 || u >= n_ || v < 0 || v >= n_) {
+            throw std::out_of_range("CsrGraphBuilder: vertex out of range");
+        }
+        if(w < 0) {
+            throw std::invalid_argument("CsrGraphBuilder: negative edge weight");
+        }
+        sources_.push_back(u);
+        targets_.push_back(v);
+        weights_.push_back(w);
+    }
+
+    CsrGraph build() const {
+        std::vector<int64_t> offsets(n_ + 1, 0);
+        for(int u : sources_) {
+            offsets[u + 1]++;
+        }
+        for(int u = 0; u < n_; u++) {
+            offsets[u + 1] += offsets[u];
+        }
+
+        std::vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+        std::vector<int> targets(sources_.size());
+        std::vector<int> weights(sources_.size());
+        for(size_t i = 0; i < sources_.size(); i++) {
+            int64_t e = next[sources_[i]]++;
+            targets[e] = targets_[i];
+            weights[e] = weights_[i];
+        }
+        return CsrGraph(std::move(offsets), std::move(targets), std::move(weights));
+    }
+
+private:
+    int n_;
+    std::vector<int> sources_;
+    std::vector<int> targets_;
+    std::vector<int> weights_;
+};
+
+// Checksum of the offsets, targets and weights: equal for graphs with
+// the same edges in the same order.
+inline uint64_t csrGraphChecksum(const CsrGraph& graph) {
+    Checksum sum;
+    size_t m = static_cast<size_t>(graph.numEdges());
+    sum.add(graph.offsets(), 8 * (static_cast<size_t>(graph.numVertices()) + 1));
+    sum.add(graph.targets(), 4 * m);
+    sum.add(graph.weights(), 4 * m);
+    return sum.value();
+}
+
+// The graph with every edge u -> v turned into v -> u, for searches that
+// walk edges backwards from a target.
+inline CsrGraph reverseCsrGraph(const CsrGraph& graph) {
+    CsrGraphBuilder builder(graph.numVertices());
+    builder.reserve(static_cast<size_t>(graph.numEdges()));
+    for(int u = 0; u < graph.numVertices(); u++) {
+        for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+            builder.addEdge(graph.target(e), u, graph.weight(e));
+        }
+    }
+    return builder.build();
+}
+
+#endif // CSR_GRAPH_H
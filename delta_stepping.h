@@ -0,0 +1,185 @@
+/*******************************************************
+ * Delta-stepping single-source shortest paths
+ *
+ * Meyer and Sanders' parallel alternative to dijkstra().
+ * Vertices are kept in buckets of width delta by their
+ * tentative distance, and the whole lowest bucket is
+ * processed at once instead of one vertex at a time:
+ *   1. relax the light edges (weight <= delta) of every
+ *      vertex in the bucket, in parallel, repeating while
+ *      they keep dropping vertices back into the bucket;
+ *   2. then relax the heavy edges of every vertex the
+ *      bucket held, once, in parallel.
+ * Distances are lowered with an atomic compare-and-swap
+ * minimum, so the threads need no locks. Each thread files
+ * the vertices it lowers in its own ring of buckets; a
+ * ring of maxWeight / delta + 2 buckets is enough, since
+ * no pending distance is further than maxWeight past the
+ * current bucket. The threads then drain the current
+ * bucket of every ring together, so there is no serial
+ * merge into a shared queue between phases.
+ *
+ * delta trades work for parallelism: delta = 1 on integer
+ * weights is Dijkstra with ties processed together, and a
+ * huge delta is Bellman-Ford. The result is always exactly
+ * the dist vector of dijkstra().
+ *******************************************************/
+
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Buckets smaller than this are relaxed on the calling thread; waking
+// the pool costs more than it saves.
+const int kDeltaSteppingParallelMin = 256;
+
+// Most buckets a run may keep per worker, i.e. the largest allowed
+// maxWeight / delta.
+const int kDeltaSteppingMaxBuckets = 1 << 20;
+
+// A bucket width that works well for most weight distributions: the
+// mean edge weight, at least 1.
+inline int defaultDelta(const CsrGraph& graph) {
+    if(graph.numEdges() == 0) return 1;
+    int64_t total = 0;
+    for(int64_t e = 0; e < graph.numEdges(); e++) total += graph.weight(e);
+    return static_cast<int>(std::max<int64_t>(1, total / graph.numEdges()));
+}
+
+// Shortest distances from source to every vertex (INT_MAX if
+// unreachable), using buckets of width delta >= 1 and numThreads threads
+// (0 = one per core). Throws if delta is below maxWeight / 2^20.
+inline std::vector<int> deltaStepping(const CsrGraph& graph, int source, int delta, int numThreads = 0)
+{
+    if(delta < 1) {
+        throw std::invalid_argument("deltaStepping: delta must be at least 1");
+    }
+    const int INF = std::numeric_limits<int>::max();
+    int n = graph.numVertices();
+    int maxWeight = 0;
+    for(int64_t e = 0; e < graph.numEdges(); e++) maxWeight = std::max(maxWeight, graph.weight(e));
+
+    // Pending distances all lie within maxWeight of the current bucket, so
+    // numBuckets consecutive buckets cover them and a ring can be reused
+    int64_t span = static_cast<int64_t>(maxWeight) / delta + 2;
+    if(span > kDeltaSteppingMaxBuckets) {
+        throw std::invalid_argument("deltaStepping: delta too small for the largest edge weight");
+    }
+    const int numBuckets = static_cast<int>(span);
+
+    std::unique_ptr<std::atomic<int>[]> dist(new std::atomic<int>[n]);
+    std::unique_ptr<std::atomic<int>[]> queued(new std::atomic<int>[n]);   // light round that last took v
+    std::unique_ptr<std::atomic<int>[]> emptied(new std::atomic<int>[n]);  // bucket whose heavy edges will cover v
+    for(int v = 0; v < n; v++) {
+        dist[v].store(INF, std::memory_order_relaxed);
+        queued[v].store(-1, std::memory_order_relaxed);
+        emptied[v].store(-1, std::memory_order_relaxed);
+    }
+    dist[source].store(0, std::memory_order_relaxed);
+
+    // Every worker files the vertices it lowers in its own ring of
+    // buckets, and the threads drain all rings' current bucket together,
+    // so bucket upkeep is as parallel as the relaxations.
+    WorkerPool pool(numThreads);
+    const int numWorkers = pool.size();
+    std::vector<std::vector<std::vector<int>>> rings(numWorkers, std::vector<std::vector<int>>(numBuckets));
+    std::vector<std::vector<int>> batch(numWorkers);    // the bucket being drained, per filing worker
+    std::vector<std::vector<int>> settled(numWorkers);  // vertices whose heavy edges are due
+    std::vector<int64_t> starts(numWorkers + 1);
+    rings[0][0].push_back(source);
+
+    // Calls fn(worker, v) for every v in lists, on the pool if there are
+    // enough of them.
+    auto forAll = [&](const std::vector<std::vector<int>>& lists, auto fn) {
+        starts[0] = 0;
+        for(int w = 0; w < numWorkers; w++) starts[w + 1] = starts[w] + lists[w].size();
+        int64_t total = starts[numWorkers];
+        if(numWorkers == 1 || total < kDeltaSteppingParallelMin) {
+            for(const auto& list : lists) {
+                for(int v : list) fn(0, v);
+            }
+            return;
+        }
+        pool.forEach(0, static_cast<int>(total), [&](int worker, int i) {
+            int w = static_cast<int>(std::upper_bound(starts.begin(), starts.end(), i) - starts.begin()) - 1;
+            fn(worker, lists[w][i - starts[w]]);
+        });
+    };
+
+    // Relaxes the light or the heavy edges of v and files every vertex
+    // whose distance dropped under its new bucket.
+    auto relax = [&](int worker, int v, bool light) {
+        int dv = dist[v].load(std::memory_order_relaxed);
+        for(int64_t e = graph.edgeBegin(v); e < graph.edgeEnd(v); e++) {
+            int weight = graph.weight(e);
+            if((weight <= delta) != light) continue;
+            int u = graph.target(e);
+            int nd = dv + weight;
+            int old = dist[u].load(std::memory_order_relaxed);
+            while(nd < old) {
+                if(dist[u].compare_exchange_weak(old, nd, std::memory_order_relaxed)) {
+                    rings[worker][(nd / delta) % numBuckets].push_back(u);
+                    break;
+                }
+            }
+        }
+    };
+
+    auto bucketEmpty = [&](int slot) {
+        for(const auto& ring : rings) {
+            if(!ring[slot].empty()) return false;
+        }
+        return true;
+    };
+
+    // Bucket indices only grow: light edges refill the current bucket at
+    // most, heavy edges always reach a later one.
+    int round = 0;
+    for(int index = 0;; index++) {
+        // Advance to the next bucket that holds anything
+        int skipped = 0;
+        while(skipped < numBuckets && bucketEmpty(index % numBuckets)) {
+            index++;
+            skipped++;
+        }
+        if(skipped == numBuckets) break;
+        const int slot = index % numBuckets;
+
+        for(auto& list : settled) list.clear();
+        while(!bucketEmpty(slot)) {
+            for(int w = 0; w < numWorkers; w++) {
+                batch[w].clear();
+                batch[w].swap(rings[w][slot]);
+            }
+            // Stale entries and duplicates are skipped; each vertex is
+            // claimed by one thread per round
+            forAll(batch, [&](int worker, int v) {
+                if(dist[v].load(std::memory_order_relaxed) / delta != index) return;
+                if(queued[v].exchange(round, std::memory_order_relaxed) == round) return;
+                if(emptied[v].exchange(index, std::memory_order_relaxed) != index) {
+                    settled[worker].push_back(v);
+                }
+                relax(worker, v, true);
+            });
+            round++;
+        }
+        forAll(settled, [&](int worker, int v) { relax(worker, v, false); });
+    }
+
+    std::vector<int> result(n);
+    for(int v = 0; v < n; v++) result[v] = dist[v].load(std::memory_order_relaxed);
+    return result;
+}
+
+#endif // DELTA_STEPPING_H
@@ -1,122 +1,374 @@
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <vector>
-#include <queue>
 #include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "alt.h"
+#include "batch_query.h"
+#include "components.h"
+#include "contraction_hierarchy.h"
+#include "csr_graph.h"
+#include "delta_stepping.h"
+#include "dijkstra.h"
+#include "graph_file.h"
+#include "parallel_bidirectional.h"
+
 using namespace std;
 
-/**
- * Dijkstra's Algorithm
- *
- * Given a directed or undirected weighted graph (with non-negative weights),
- * find the shortest path distances from a source vertex to all other vertices.
- *
- * Key Points:
- *  1. We use an adjacency list where graph[u] contains pairs (v, weight)
- *     indicating there's an edge from u to v with a given weight.
- *  2. We use a min-heap priority queue that always gives us the vertex
- *     with the smallest current distance from the source.
- *  3. Distances are stored in a vector `dist`. Initially, dist[u] = infinity
- *     for all vertices u except the source which is 0.
- *  4. We repeatedly extract the vertex with the smallest distance, then
- *     update its neighbors if a shorter path is found via this vertex.
- */
-
-vector<int> dijkstra(int n, // number of vertices
-                     const vector<vector<pair<int,int>>>& graph, // adjacency list
-                     int source)
+// Reads an undirected graph from text and packs it into a CSR graph.
+// Throws on malformed input.
+//
+// Example usage:
+// Input format:
+// n m
+// Then m lines of: u v w
+//   where u, v are vertices (0-based) and w is edge weight
+// Then a line containing the source vertex s.
+// This example demonstrates reading an undirected graph, but
+// Dijkstra works for directed graphs with non-negative weights as well.
+//
+// Sample input:
+// 5 6
+// 0 1 4
+// 0 2 2
+// 1 2 3
+// 1 3 2
+// 2 3 4
+// 3 4 1
+// 0
+//
+// Explanation of sample:
+// There are 5 vertices (0 through 4), 6 edges. We read them and
+// then run Dijkstra from source = 0.
+CsrGraph readGraphText(istream& in)
 {
-    // Initialize distance array with "infinity"
-    const int INF = numeric_limits<int>::max();
-    vector<int> dist(n, INF);
-    dist[source] = 0;
-
-    // Min-heap priority queue of (distance, vertex).
-    // Using a pair here ensures it sorts by the first element (distance).
-    priority_queue<pair<int,int>,
-                   vector<pair<int,int>>,
-                   greater<pair<int,int>>> pq;
-
-    // Start by pushing the source vertex with distance 0
-    pq.push({0, source});
-
-    // While there are vertices to process in the queue
-    while(!pq.empty()) {
-        // Extract vertex u with the smallest distance
-        auto [currentDist, u] = pq.top();
-        pq.pop();
-
-        // If we've already found a better path before, skip this one
-        if(currentDist > dist[u]) {
-            continue;
+    int n, m;
+    in >> n >> m;
+    if(!in || n <= 0 || m < 0) {
+        throw runtime_error("Invalid graph dimensions.");
+    }
+
+    // Edges are collected and then packed into a CSR graph
+    CsrGraphBuilder builder(n);
+    builder.reserve(2 * static_cast<size_t>(m));
+
+    for(int i = 0; i < m; i++){
+        int u, v, w;
+        if(!(in >> u >> v >> w)) {
+            throw runtime_error("Edge list ended early.");
         }
 
-        // Relax edges out of u
-        for(const auto& edge : graph[u]) {
-            int v = edge.first;      // neighbor vertex
-            int weight = edge.second; // edge weight u -> v
+        // For undirected graphs, add edges both ways:
+        builder.addEdge(u, v, w);
+        builder.addEdge(v, u, w);
 
-            // If a shorter path to v is found
-            if(dist[u] + weight < dist[v]) {
-                dist[v] = dist[u] + weight;
-                pq.push({dist[v], v});
-            }
+        // If directed, only add the edge (u->v)
+        // builder.addEdge(u, v, w);
+    }
+
+    return builder.build();
+}
+
+// Answers "s t" pairs from stdin until EOF with distance(s, t). Pairs in
+// different components are answered INF without calling distance.
+template <class Distance>
+int answerQueries(const GraphComponents& components, Distance distance)
+{
+    int n = components.numVertices();
+    int s, t;
+    while(cin >> s >> t) {
+        if(s < 0 || s >= n || t < 0 || t >= n) {
+            cerr << "Invalid query vertex.\n";
+            return 1;
+        }
+        int d = components.connected(s, t) ? distance(s, t) : numeric_limits<int>::max();
+        cout << "Distance from " << s << " to " << t << ": ";
+        if(d == numeric_limits<int>::max()) {
+            cout << "INF\n";
+        } else {
+            cout << d << "\n";
+        }
+    }
+    return 0;
+}
+
+// Point-to-point queries with early exit, one or both directions, the
+// latter optionally with each direction on its own thread.
+template <class Queue>
+int answerPointToPoint(const CsrGraph& graph, const GraphComponents& components, const string& mode)
+{
+    // Text input is undirected, but binary graph files need not be
+    CsrGraph reverse = reverseCsrGraph(graph);
+    if(mode == "bi-parallel") {
+        ParallelBidirectionalDijkstra<Queue> query(graph, reverse);
+        return answerQueries(components, [&](int s, int t) { return query.distance(s, t); });
+    }
+    PointToPointDijkstra<Queue> query(graph, reverse);
+    if(mode == "bi") {
+        return answerQueries(components, [&](int s, int t) { return query.bidirectionalDistance(s, t); });
+    }
+    return answerQueries(components, [&](int s, int t) { return query.distance(s, t); });
+}
+
+// Reads every "s t" pair from stdin first, answers them on a work-stealing
+// pool of numThreads workers and prints the results in input order.
+template <class Queue>
+int answerBatch(const CsrGraph& graph, const string& mode, int numThreads)
+{
+    int n = graph.numVertices();
+    vector<pair<int,int>> queries;
+    int s, t;
+    while(cin >> s >> t) {
+        if(s < 0 || s >= n || t < 0 || t >= n) {
+            cerr << "Invalid query vertex.\n";
+            return 1;
         }
+        queries.push_back({s, t});
     }
 
-    return dist;
+    CsrGraph reverse = reverseCsrGraph(graph);
+    BatchDijkstra<Queue> batch(graph, reverse, numThreads);
+    vector<int> distances = batch.run(queries, mode == "bi");
+    for(size_t i = 0; i < queries.size(); i++) {
+        cout << "Distance from " << queries[i].first << " to " << queries[i].second << ": ";
+        if(distances[i] == numeric_limits<int>::max()) {
+            cout << "INF\n";
+        } else {
+            cout << distances[i] << "\n";
+        }
+    }
+
+    const vector<WorkerStats>& stats = batch.workerStats();
+    for(size_t w = 0; w < stats.size(); w++) {
+        cerr << "worker " << w << ": " << stats[w].tasks << " queries, "
+             << stats[w].steals << " steals, busy " << stats[w].busySeconds * 1000
+             << " ms, idle " << stats[w].idleSeconds * 1000 << " ms\n";
+    }
+    return 0;
+}
+
+void printUsage(const char* program)
+{
+    cerr << "Usage: " << program << " [--queue binary|4ary|radix|indexed|indexed8] [--graph FILE] < input\n"
+         << "       " << program << " --delta-stepping DELTA [--threads N] [--graph FILE] < input\n"
+         << "       " << program << " --p2p uni|bi|bi-parallel [--batch] [--queue ...] [--graph FILE] < input\n"
+         << "       " << program << " --ch [--threads N] [--graph FILE] < input\n"
+         << "       " << program << " --alt K [--landmarks FILE] [--graph FILE] < input\n"
+         << "       " << program << " --convert FILE < input\n"
+         << "  --queue    priority queue used by dijkstra (default binary;\n"
+         << "             indexed/indexed8 = 4-/8-ary heap with decrease-key)\n"
+         << "  --delta-stepping  parallel delta-stepping with bucket width DELTA\n"
+         << "             (0 = mean edge weight) instead of dijkstra\n"
+         << "  --graph    memory-map a binary graph file; stdin then only\n"
+         << "             holds the source vertex or the queries\n"
+         << "  --p2p      answer \"s t\" queries from stdin with dijkstra stopping\n"
+         << "             at t (uni), searching from both ends (bi), or from\n"
+         << "             both ends on two threads (bi-parallel)\n"
+         << "  --batch    read all --p2p uni|bi queries first and answer them\n"
+         << "             on a work-stealing thread pool\n"
+         << "  --ch       build a contraction hierarchy, then answer \"s t\"\n"
+         << "             point-to-point queries from the rest of stdin\n"
+         << "  --alt      A* with K landmarks (ALT) for \"s t\" queries from stdin\n"
+         << "  --landmarks  landmark table to load, or to build and save if FILE\n"
+         << "             does not exist yet\n"
+         << "  --threads  threads for preprocessing, --batch and --delta-stepping\n"
+         << "             (default: all cores)\n"
+         << "  --convert  read the text graph from stdin, write it to FILE\n"
+         << "             in the binary format and exit\n";
 }
 
-int main()
+int main(int argc, char* argv[])
 {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
-    // Example usage:
-    // Input format:
-    // n m
-    // Then m lines of: u v w
-    //   where u, v are vertices (0-based) and w is edge weight
-    // Then a line containing the source vertex s.
-    // This example demonstrates reading an undirected graph, but
-    // Dijkstra works for directed graphs with non-negative weights as well.
-    //
-    // Sample input:
-    // 5 6
-    // 0 1 4
-    // 0 2 2
-    // 1 2 3
-    // 1 3 2
-    // 2 3 4
-    // 3 4 1
-    // 0
-    //
-    // Explanation of sample:
-    // There are 5 vertices (0 through 4), 6 edges. We read them and
-    // then run Dijkstra from source = 0.
+    string queueName = "binary";
+    string graphFile, convertFile;
+    bool useCh = false;
+    bool batch = false;
+    string pointToPoint;
+    int numThreads = 0;
+    int numLandmarks = 0;
+    string landmarkFile;
+    int delta = -1;
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--queue" && i + 1 < argc) {
+            queueName = argv[++i];
+        } else if(arg == "--graph" && i + 1 < argc) {
+            graphFile = argv[++i];
+        } else if(arg == "--convert" && i + 1 < argc) {
+            convertFile = argv[++i];
+        } else if(arg == "--p2p" && i + 1 < argc) {
+            pointToPoint = argv[++i];
+        } else if(arg == "--batch") {
+            batch = true;
+        } else if(arg == "--ch") {
+            useCh = true;
+        } else if(arg == "--alt" && i + 1 < argc) {
+            numLandmarks = atoi(argv[++i]);
+            if(numLandmarks < 1) {
+                cerr << "--alt needs at least one landmark\n";
+                return 1;
+            }
+        } else if(arg == "--landmarks" && i + 1 < argc) {
+            landmarkFile = argv[++i];
+        } else if(arg == "--delta-stepping" && i + 1 < argc) {
+            delta = atoi(argv[++i]);
+            if(delta < 0) {
+                cerr << "--delta-stepping needs a width of 0 or more\n";
+                return 1;
+            }
+        } else if(arg == "--threads" && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if(queueName != "binary" && queueName != "4ary" &&
+       queueName != "radix" && queueName != "indexed" && queueName != "indexed8") {
+        cerr << "Unknown queue: " << queueName << "\n";
+        return 1;
+    }
+    if(!pointToPoint.empty() && pointToPoint != "uni" && pointToPoint != "bi" &&
+       pointToPoint != "bi-parallel") {
+        cerr << "--p2p must be uni, bi or bi-parallel\n";
+        return 1;
+    }
+    if(batch && pointToPoint != "uni" && pointToPoint != "bi") {
+        cerr << "--batch needs --p2p uni or bi\n";
+        return 1;
+    }
+    int modes = !pointToPoint.empty() + useCh + (numLandmarks > 0) + (delta >= 0) + !convertFile.empty();
+    if(modes > 1) {
+        cerr << "--p2p, --ch, --alt, --delta-stepping and --convert exclude each other\n";
+        return 1;
+    }
+    if(!landmarkFile.empty() && numLandmarks <= 0) {
+        cerr << "--landmarks needs --alt K\n";
+        return 1;
+    }
+    if(queueName != "binary" && (useCh || numLandmarks > 0 || delta >= 0)) {
+        cerr << "--queue only applies to dijkstra and --p2p\n";
+        return 1;
+    }
 
-    int n, m;
-    cin >> n >> m;
+    CsrGraph graph;
+    try {
+        if(!graphFile.empty()) {
+            graph = mapCsrGraphFile(graphFile);
+        } else {
+            graph = readGraphText(cin);
+        }
+        if(!convertFile.empty()) {
+            writeCsrGraphFile(convertFile, graph);
+            cerr << "Wrote " << graph.numVertices() << " vertices and "
+                 << graph.numEdges() << " edges to " << convertFile << "\n";
+            return 0;
+        }
+    } catch(const exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
 
-    // Graph representation: graph[u] = list of (v, weight) pairs
-    vector<vector<pair<int,int>>> graph(n);
+    int n = graph.numVertices();
 
-    for(int i = 0; i < m; i++){
-        int u, v, w;
-        cin >> u >> v >> w;
-        
-        // For undirected graphs, add edges both ways:
-        graph[u].push_back({v, w});
-        graph[v].push_back({u, w});
-        
-        // If directed, only add the edge (u->v)
-        // graph[u].push_back({v, w});
+    if(batch) {
+        if(queueName == "indexed") {
+            return answerBatch<IndexedDaryHeap<4>>(graph, pointToPoint, numThreads);
+        } else if(queueName == "indexed8") {
+            return answerBatch<IndexedDaryHeap<8>>(graph, pointToPoint, numThreads);
+        } else if(queueName == "radix") {
+            return answerBatch<RadixHeap>(graph, pointToPoint, numThreads);
+        } else if(queueName == "4ary") {
+            return answerBatch<DaryHeap<4>>(graph, pointToPoint, numThreads);
+        }
+        return answerBatch<BinaryHeap>(graph, pointToPoint, numThreads);
+    }
+
+    // Point-to-point modes reject pairs in different components up front
+    GraphComponents components;
+    if(!pointToPoint.empty() || useCh || numLandmarks > 0) {
+        components = GraphComponents(graph, numThreads);
     }
 
-    int source;
+    if(!pointToPoint.empty()) {
+        if(queueName == "indexed") {
+            return answerPointToPoint<IndexedDaryHeap<4>>(graph, components, pointToPoint);
+        } else if(queueName == "indexed8") {
+            return answerPointToPoint<IndexedDaryHeap<8>>(graph, components, pointToPoint);
+        } else if(queueName == "radix") {
+            return answerPointToPoint<RadixHeap>(graph, components, pointToPoint);
+        } else if(queueName == "4ary") {
+            return answerPointToPoint<DaryHeap<4>>(graph, components, pointToPoint);
+        }
+        return answerPointToPoint<BinaryHeap>(graph, components, pointToPoint);
+    }
+
+    if(useCh) {
+        ContractionHierarchy ch = buildContractionHierarchyParallel(graph, numThreads);
+        cerr << "Contracted " << n << " vertices, added " << ch.numShortcuts() << " shortcuts\n";
+
+        ChQuery query(ch);
+        return answerQueries(components, [&](int s, int t) { return query.distance(s, t); });
+    }
+
+    if(numLandmarks > 0) {
+        LandmarkTable landmarks;
+        try {
+            ifstream existing(landmarkFile);
+            if(!landmarkFile.empty() && existing.is_open()) {
+                landmarks = mapLandmarkFile(landmarkFile, graph);
+                if(landmarks.numLandmarks() != numLandmarks) {
+                    throw runtime_error(landmarkFile + " holds " + to_string(landmarks.numLandmarks()) +
+                                        " landmarks, not " + to_string(numLandmarks));
+                }
+            } else {
+                landmarks = LandmarkTable::build(graph, numLandmarks, numThreads);
+                if(!landmarkFile.empty()) {
+                    writeLandmarkFile(landmarkFile, landmarks, graph);
+                }
+            }
+        } catch(const exception& e) {
+            cerr << e.what() << "\n";
+            return 1;
+        }
+
+        AltQuery query(graph, landmarks);
+        return answerQueries(components, [&](int s, int t) { return query.distance(s, t); });
+    }
+
+    int source = -1;
     cin >> source;
+    if(source < 0 || source >= n) {
+        cerr << "Invalid source vertex.\n";
+        return 1;
+    }
 
-    // Run Dijkstra from the given source
-    vector<int> distances = dijkstra(n, graph, source);
+    // Run Dijkstra (or delta-stepping) from the given source
+    vector<int> distances;
+    if(delta >= 0) {
+        try {
+            distances = deltaStepping(graph, source, delta == 0 ? defaultDelta(graph) : delta, numThreads);
+        } catch(const exception& e) {
+            cerr << e.what() << "\n";
+            return 1;
+        }
+    } else if(queueName == "indexed") {
+        distances = dijkstra<IndexedDaryHeap<4>>(graph, source);
+    } else if(queueName == "indexed8") {
+        distances = dijkstra<IndexedDaryHeap<8>>(graph, source);
+    } else if(queueName == "radix") {
+        distances = dijkstra<RadixHeap>(graph, source);
+    } else if(queueName == "4ary") {
+        distances = dijkstra<DaryHeap<4>>(graph, source);
+    } else {
+        distances = dijkstra<BinaryHeap>(graph, source);
+    }
 
     // Output distances
     cout << "Shortest distances from vertex " << source << ":\n";
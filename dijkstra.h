@@ -0,0 +1,205 @@
+#ifndef DIJKSTRA_H
+#define DIJKSTRA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "priority_queues.h"
+
+/**
+ * Dijkstra's Algorithm
+ *
+ * Given a directed or undirected weighted graph (with non-negative weights),
+ * find the shortest path distances from a source vertex to all other vertices.
+ *
+ * Key Points:
+ *  1. The graph is a CsrGraph (csr_graph.h): the edges out of u are the
+ *     ids in [edgeBegin(u), edgeEnd(u)), each with a target vertex v
+ *     and a weight.
+ *  2. We use a min-priority queue that always gives us the vertex
+ *     with the smallest current distance from the source. The queue type
+ *     is a template parameter; any queue from priority_queues.h works
+ *     (BinaryHeap, DaryHeap<4>, RadixHeap, ...).
+ *  3. Distances are stored in a vector `dist`. Initially, dist[u] = infinity
+ *     for all vertices u except the source which is 0.
+ *  4. We repeatedly extract the vertex with the smallest distance, then
+ *     update its neighbors if a shorter path is found via this vertex.
+ */
+
+template <class Queue = BinaryHeap>
+std::vector<int> dijkstra(const CsrGraph& graph, int source)
+{
+    int n = graph.numVertices();
+
+    // Initialize distance array with "infinity"
+    const int INF = std::numeric_limits<int>::max();
+    std::vector<int> dist(n, INF);
+    dist[source] = 0;
+
+    // Min-priority queue of (distance, vertex).
+    Queue pq;
+    pq.reset(n);
+
+    // Start by pushing the source vertex with distance 0
+    pq.push(0, source);
+
+    // While there are vertices to process in the queue
+    while(!pq.empty()) {
+        // Extract vertex u with the smallest distance
+        auto [currentDist, u] = pq.pop();
+
+        // If we've already found a better path before, skip this one
+        // (stale entries only occur with lazy-deletion queues)
+        if(currentDist > dist[u]) {
+            continue;
+        }
+
+        // Relax edges out of u
+        for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+            int v = graph.target(e);      // neighbor vertex
+            int weight = graph.weight(e); // edge weight u -> v
+
+            // If a shorter path to v is found
+            if(dist[u] + weight < dist[v]) {
+                dist[v] = dist[u] + weight;
+                pq.push(dist[v], v);
+            }
+        }
+    }
+
+    return dist;
+}
+
+/**
+ * Point-to-point queries
+ *
+ * When only dist(source, target) is needed, the search can stop early:
+ *  - distance() settles vertices in order and returns as soon as the
+ *    target is settled, exploring a ball of radius dist(s, t).
+ *  - bidirectionalDistance() also searches backwards from the target
+ *    over the reverse graph and alternates between the two sides. The
+ *    best path seen through a vertex reached from both sides is kept,
+ *    and the search stops once the smallest keys of the two sides add up
+ *    to at least that best path. Two balls of about half the radius
+ *    usually hold far fewer vertices than one full-radius ball.
+ * For undirected graphs the graph is its own reverse; for directed ones
+ * pass reverseCsrGraph(graph). Per-vertex state is stamped per query, so
+ * a query costs nothing for vertices it never reaches; keep one object
+ * per thread and reuse it.
+ */
+template <class Queue = BinaryHeap>
+class PointToPointDijkstra {
+public:
+    PointToPointDijkstra(const CsrGraph& graph, const CsrGraph& reverse)
+        : graphs_{&graph, &reverse}
+    {
+        if(reverse.numVertices() != graph.numVertices()) {
+            throw std::invalid_argument("PointToPointDijkstra: reverse graph does not match");
+        }
+        for(int side = 0; side < 2; side++) {
+            dist_[side].resize(graph.numVertices());
+            stamp_[side].assign(graph.numVertices(), 0);
+        }
+    }
+
+    // Shortest distance from source to target (INT_MAX if unreachable),
+    // stopping as soon as the target is settled.
+    int distance(int source, int target) {
+        const int INF = std::numeric_limits<int>::max();
+        beginQuery();
+        const CsrGraph& graph = *graphs_[0];
+        queues_[0].reset(graph.numVertices());
+        set(0, source, 0);
+        queues_[0].push(0, source);
+        while(!queues_[0].empty()) {
+            auto [currentDist, u] = queues_[0].pop();
+            if(currentDist > get(0, u)) continue;
+            settled_++;
+            if(u == target) return currentDist;
+            for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+                int v = graph.target(e);
+                int nd = currentDist + graph.weight(e);
+                if(nd < get(0, v)) {
+                    set(0, v, nd);
+                    queues_[0].push(nd, v);
+                }
+            }
+        }
+        return INF;
+    }
+
+    // Same result as distance(), searching from both ends.
+    int bidirectionalDistance(int source, int target) {
+        const int INF = std::numeric_limits<int>::max();
+        beginQuery();
+        if(source == target) return 0;
+        int n = graphs_[0]->numVertices();
+        int ends[2] = {source, target};
+        int lastKey[2] = {0, 0};  // key of each side's last pop; never decreases
+        for(int side = 0; side < 2; side++) {
+            queues_[side].reset(n);
+            set(side, ends[side], 0);
+            queues_[side].push(0, ends[side]);
+        }
+
+        int best = INF;
+        int side = 0;
+        while(!queues_[0].empty() && !queues_[1].empty()) {
+            auto [currentDist, u] = queues_[side].pop();
+            if(currentDist > get(side, u)) continue;
+            lastKey[side] = currentDist;
+            // Every unseen path has length >= both sides' minimum keys
+            if(best != INF && currentDist + lastKey[1 - side] >= best) break;
+            settled_++;
+
+            const CsrGraph& graph = *graphs_[side];
+            for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+                int v = graph.target(e);
+                int nd = currentDist + graph.weight(e);
+                if(nd < get(side, v)) {
+                    set(side, v, nd);
+                    queues_[side].push(nd, v);
+                }
+                int other = get(1 - side, v);
+                if(other != INF && nd + other < best) best = nd + other;
+            }
+            side = 1 - side;
+        }
+        return best;
+    }
+
+    // Vertices settled by the last query, both directions together.
+    int settled() const { return settled_; }
+
+private:
+    void beginQuery() {
+        settled_ = 0;
+        if(++current_ == 0) {
+            for(auto& stamps : stamp_) std::fill(stamps.begin(), stamps.end(), 0);
+            current_ = 1;
+        }
+    }
+
+    int get(int side, int v) const {
+        return stamp_[side][v] == current_ ? dist_[side][v] : std::numeric_limits<int>::max();
+    }
+
+    void set(int side, int v, int d) {
+        dist_[side][v] = d;
+        stamp_[side][v] = current_;
+    }
+
+    const CsrGraph* graphs_[2];  // forward, reverse
+    std::vector<int> dist_[2];
+    std::vector<uint32_t> stamp_[2];
+    uint32_t current_ = 0;
+    Queue queues_[2];
+    int settled_ = 0;
+};
+
+#endif // DIJKSTRA_H
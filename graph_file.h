@@ -0,0 +1,138 @@
+/*******************************************************
+ * Binary CSR graph files
+ *
+ * Layout (host byte order, all sections 8-byte aligned):
+ *   GraphFileHeader                      32 bytes
+ *   offsets[numVertices + 1]  int64
+ *   targets[numEdges]         int32
+ *   weights[numEdges]         int32
+ * The arrays are stored exactly as CsrGraph uses them, so
+ * mapCsrGraphFile() only validates the header and the
+ * edges in one pass, then points a CsrGraph at the mapped
+ * pages - no parsing, and the page cache is shared
+ * between processes.
+ *******************************************************/
+
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "csr_graph.h"
+#include "mapped_file.h"
+
+struct GraphFileHeader {
+    char magic[8];         // "CSRGRAPH"
+    uint32_t version;      // kGraphFileVersion
+    uint32_t byteOrder;    // kGraphFileByteOrder as written by the producer
+    uint64_t numVertices;
+    uint64_t numEdges;
+};
+
+static_assert(sizeof(GraphFileHeader) == 32, "GraphFileHeader must stay 32 bytes");
+
+const char kGraphFileMagic[8] = {'C', 'S', 'R', 'G', 'R', 'A', 'P', 'H'};
+const uint32_t kGraphFileVersion = 1;
+const uint32_t kGraphFileByteOrder = 0x01020304;
+
+// Bytes from the start of the file to each array.
+inline uint64_t graphFileTargetsOffset(uint64_t n) {
+    return sizeof(GraphFileHeader) + 8 * (n + 1);
+}
+
+inline uint64_t graphFileWeightsOffset(uint64_t n, uint64_t m) {
+    return graphFileTargetsOffset(n) + ((4 * m + 7) & ~uint64_t(7));
+}
+
+inline uint64_t graphFileSize(uint64_t n, uint64_t m) {
+    return graphFileWeightsOffset(n, m) + 4 * m;
+}
+
+// Writes graph to path in the binary format above. Throws on I/O errors.
+inline void writeCsrGraphFile(const std::string& path, const CsrGraph& graph) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        throw std::runtime_error("Could not create " + path);
+    }
+
+    uint64_t n = graph.numVertices();
+    uint64_t m = graph.numEdges();
+
+    GraphFileHeader header;
+    std::memcpy(header.magic, kGraphFileMagic, sizeof(header.magic));
+    header.version = kGraphFileVersion;
+    header.byteOrder = kGraphFileByteOrder;
+    header.numVertices = n;
+    header.numEdges = m;
+
+    const char padding[8] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(graph.offsets()), 8 * (n + 1));
+    out.write(reinterpret_cast<const char*>(graph.targets()), 4 * m);
+    out.write(padding, graphFileWeightsOffset(n, m) - graphFileTargetsOffset(n) - 4 * m);
+    out.write(reinterpret_cast<const char*>(graph.weights()), 4 * m);
+    if(!out.flush()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+// Maps a file written by writeCsrGraphFile read-only and returns a graph
+// that views it. The mapping lives as long as the graph or its copies.
+// Offsets, targets and weights are checked so a corrupt file cannot send
+// a search out of bounds or break its non-negative weight assumption.
+inline CsrGraph mapCsrGraphFile(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    if(file->size() < sizeof(GraphFileHeader)) {
+        throw std::runtime_error(path + " is too small to be a graph file");
+    }
+
+    GraphFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(std::memcmp(header.magic, kGraphFileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a graph file");
+    }
+    if(header.byteOrder != kGraphFileByteOrder) {
+        throw std::runtime_error(path + " was written with a different byte order");
+    }
+    if(header.version != kGraphFileVersion) {
+        throw std::runtime_error(path + " has unsupported graph file version " +
+                                 std::to_string(header.version));
+    }
+
+    uint64_t n = header.numVertices;
+    uint64_t m = header.numEdges;
+    if(n >= static_cast<uint64_t>(INT32_MAX) || m >= (uint64_t(1) << 60) ||
+       file->size() != graphFileSize(n, m)) {
+        throw std::runtime_error(path + " has an inconsistent size");
+    }
+
+    const uint8_t* base = file->data();
+    auto offsets = reinterpret_cast<const int64_t*>(base + sizeof(GraphFileHeader));
+    auto targets = reinterpret_cast<const int*>(base + graphFileTargetsOffset(n));
+    auto weights = reinterpret_cast<const int*>(base + graphFileWeightsOffset(n, m));
+    if(offsets[0] != 0 || offsets[n] != static_cast<int64_t>(m)) {
+        throw std::runtime_error(path + " has corrupt offsets");
+    }
+    for(uint64_t u = 0; u < n; u++) {
+        if(offsets[u + 1] < offsets[u]) {
+            throw std::runtime_error(path + " has corrupt offsets");
+        }
+    }
+    for(uint64_t e = 0; e < m; e++) {
+        if(targets[e] < 0 || static_cast<uint64_t>(targets[e]) >= n) {
+            throw std::runtime_error(path + " has an edge to a vertex out of range");
+        }
+        if(weights[e] < 0) {
+            throw std::runtime_error(path + " has a negative edge weight");
+        }
+    }
+    return CsrGraph(static_cast<int>(n), static_cast<int64_t>(m),
+                    offsets, targets, weights, std::move(file));
+}
+
+#endif // GRAPH_FILE_H
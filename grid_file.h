@@ -0,0 +1,179 @@
+/*******************************************************
+ * Binary map files for the A* example
+ *
+ * Layout (host byte order):
+ *   GridFileHeader   32 bytes
+ *   payload, in one of two cell encodings:
+ *     kGridEncodingBytes - the padded GridMap buffer as is,
+ *       (rows + 2) * (cols + 2) bytes including the border.
+ *       mapGridFile() points a GridMap straight at it.
+ *     kGridEncodingBits  - rows * cols bits, row-major, no
+ *       border, least significant bit first; 1 = obstacle.
+ *       8x smaller on disk, unpacked into memory on load.
+ * Byte-encoded files load in constant time and every
+ * process that maps them shares one page-cache copy.
+ *******************************************************/
+
+#ifndef GRID_FILE_H
+#define GRID_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_map.h"
+#include "mapped_file.h"
+
+struct GridFileHeader {
+    char magic[8];         // "GRIDMAP1"
+    uint32_t version;      // kGridFileVersion
+    uint32_t byteOrder;    // kGridFileByteOrder as written by the producer
+    uint32_t encoding;     // kGridEncodingBytes or kGridEncodingBits
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(GridFileHeader) == 32, "GridFileHeader must stay 32 bytes");
+
+const char kGridFileMagic[8] = {'G', 'R', 'I', 'D', 'M', 'A', 'P', '1'};
+const uint32_t kGridFileVersion = 1;
+const uint32_t kGridFileByteOrder = 0x01020304;
+const uint32_t kGridEncodingBytes = 0;
+const uint32_t kGridEncodingBits = 1;
+
+inline uint64_t gridPayloadSize(uint32_t encoding, uint64_t rows, uint64_t cols) {
+    if(encoding == kGridEncodingBytes) {
+        return (rows + 2) * (cols + 2);
+    }
+    return (rows * cols + 7) / 8;
+}
+
+// Writes grid to path in the given encoding. Throws on I/O errors.
+inline void writeGridFile(const std::string& path, const GridMap& grid,
+                          uint32_t encoding = kGridEncodingBytes)
+{
+    if(encoding != kGridEncodingBytes && encoding != kGridEncodingBits) {
+        throw std::invalid_argument("writeGridFile: unknown encoding");
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        throw std::runtime_error("Could not create " + path);
+    }
+
+    GridFileHeader header;
+    std::memcpy(header.magic, kGridFileMagic, sizeof(header.magic));
+    header.version = kGridFileVersion;
+    header.byteOrder = kGridFileByteOrder;
+    header.encoding = encoding;
+    header.rows = static_cast<uint32_t>(grid.rows());
+    header.cols = static_cast<uint32_t>(grid.cols());
+    header.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if(encoding == kGridEncodingBytes) {
+        out.write(reinterpret_cast<const char*>(grid.data()), grid.size());
+    } else {
+        std::vector<uint8_t> bits(gridPayloadSize(encoding, grid.rows(), grid.cols()), 0);
+        uint64_t bit = 0;
+        for(int r = 0; r < grid.rows(); r++) {
+            for(int c = 0; c < grid.cols(); c++, bit++) {
+                if(grid.blocked(r, c)) {
+                    bits[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+                }
+            }
+        }
+        out.write(reinterpret_cast<const char*>(bits.data()), bits.size());
+    }
+    if(!out.flush()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+// True if the file at path starts with the binary map magic.
+inline bool isGridFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kGridFileMagic)] = {};
+    return in.read(magic, sizeof(magic)) &&
+           std::memcmp(magic, kGridFileMagic, sizeof(magic)) == 0;
+}
+
+// Maps a binary map file read-only. Byte-encoded maps are used in place;
+// bit-encoded maps are unpacked into an owned GridMap.
+inline GridMap mapGridFile(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    if(file->size() < sizeof(GridFileHeader)) {
+        throw std::runtime_error(path + " is too small to be a map file");
+    }
+
+    GridFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(std::memcmp(header.magic, kGridFileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a map file");
+    }
+    if(header.byteOrder != kGridFileByteOrder) {
+        throw std::runtime_error(path + " was written with a different byte order");
+    }
+    if(header.version != kGridFileVersion) {
+        throw std::runtime_error(path + " has unsupported map file version " +
+                                 std::to_string(header.version));
+    }
+    if(header.encoding != kGridEncodingBytes && header.encoding != kGridEncodingBits) {
+        throw std::runtime_error(path + " has an unknown cell encoding");
+    }
+    if(header.rows == 0 || header.cols == 0 || header.rows > INT32_MAX || header.cols > INT32_MAX ||
+       file->size() != sizeof(GridFileHeader) +
+                       gridPayloadSize(header.encoding, header.rows, header.cols)) {
+        throw std::runtime_error(path + " has an inconsistent size");
+    }
+
+    int rows = static_cast<int>(header.rows);
+    int cols = static_cast<int>(header.cols);
+    const uint8_t* payload = file->data() + sizeof(GridFileHeader);
+    if(header.encoding == kGridEncodingBytes) {
+        // The search relies on the border for bounds checks, so verify it
+        // (O(rows + cols)) before trusting the buffer.
+        GridMap grid(rows, cols, payload, std::move(file));
+        int last = grid.size() - grid.stride();
+        for(int c = 0; c < grid.stride(); c++) {
+            if(!grid.blocked(c) || !grid.blocked(last + c)) {
+                throw std::runtime_error(path + " has an open border cell");
+            }
+        }
+        for(int r = 0; r < rows; r++) {
+            if(!grid.blocked(grid.index(r, -1)) || !grid.blocked(grid.index(r, cols))) {
+                throw std::runtime_error(path + " has an open border cell");
+            }
+        }
+        return grid;
+    }
+
+    GridMap grid(rows, cols);
+    uint64_t bit = 0;
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++, bit++) {
+            if((payload[bit >> 3] >> (bit & 7)) & 1) {
+                grid.setBlocked(r, c, true);
+            }
+        }
+    }
+    return grid;
+}
+
+// Loads either map format, choosing by the file's leading bytes.
+inline GridMap loadGridFile(const std::string& path) {
+    if(isGridFile(path)) {
+        return mapGridFile(path);
+    }
+    std::ifstream in(path);
+    if(!in.is_open()) {
+        throw std::runtime_error("Error: Could not open " + path);
+    }
+    return readGridText(in);
+}
+
+#endif // GRID_FILE_H
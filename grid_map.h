@@ -0,0 +1,155 @@
+/*******************************************************
+ * GridMap - flat occupancy grid for the A* example
+ *
+ * The map is stored row-major in a single buffer with
+ * one byte per cell:
+ *   0 = walkable cell
+ *   1 = obstacle cell
+ * A one-cell border of obstacles surrounds the map, so
+ * neighbours of any real cell can be read without a
+ * bounds check. The buffer is either owned or a view of
+ * a memory-mapped map file (see grid_file.h).
+ *******************************************************/
+
+#ifndef GRID_MAP_H
+#define GRID_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "checksum.h"
+
+class GridMap {
+public:
+    GridMap() = default;
+
+    // Creates a rows x cols map with every cell walkable.
+    GridMap(int rows, int cols) {
+        setDimensions(rows, cols);
+        auto storage = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size_), 1);
+        for(int r = 0; r < rows; r++) {
+            std::fill_n(storage->begin() + index(r, 0), cols, 0);
+        }
+        cells_ = storage->data();
+        owned_ = storage.get();
+        owner_ = std::move(storage);
+    }
+
+    // Views an existing padded cell buffer of (rows + 2) * (cols + 2)
+    // bytes, e.g. a memory-mapped map file. owner keeps the buffer alive;
+    // the first setBlocked() call copies it.
+    GridMap(int rows, int cols, const uint8_t* cells, std::shared_ptr<const void> owner) {
+        setDimensions(rows, cols);
+        cells_ = cells;
+        owner_ = std::move(owner);
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    // Index distance between vertically adjacent cells.
+    int stride() const { return stride_; }
+
+    // Number of cells including the border; indices are in [0, size()).
+    int size() const { return size_; }
+
+    // Flat index of (row, col). Row and col must be inside the map.
+    int index(int row, int col) const { return (row + 1) * stride_ + (col + 1); }
+    int rowOf(int idx) const { return idx / stride_ - 1; }
+    int colOf(int idx) const { return idx % stride_ - 1; }
+
+    bool inBounds(int row, int col) const {
+        return row >= 0 && row < rows_ && col >= 0 && col < cols_;
+    }
+
+    // Border cells always report blocked.
+    bool blocked(int idx) const { return cells_[idx] != 0; }
+    bool blocked(int row, int col) const { return blocked(index(row, col)); }
+
+    // The padded cell buffer, size() bytes.
+    const uint8_t* data() const { return cells_; }
+
+    // Copies are cheap and share cells until one of them is modified.
+    void setBlocked(int row, int col, bool obstacle) {
+        if(owned_ == nullptr || owner_.use_count() > 1) {
+            auto storage = std::make_shared<std::vector<uint8_t>>(cells_, cells_ + size_);
+            cells_ = storage->data();
+            owned_ = storage.get();
+            owner_ = std::move(storage);
+        }
+        (*owned_)[index(row, col)] = obstacle ? 1 : 0;
+    }
+
+private:
+    void setDimensions(int rows, int cols) {
+        if(rows <= 0 || cols <= 0) {
+            throw std::invalid_argument("GridMap: invalid dimensions");
+        }
+        long long padded = (static_cast<long long>(rows) + 2) * (static_cast<long long>(cols) + 2);
+        if(padded > std::numeric_limits<int>::max()) {
+            throw std::length_error("GridMap: map too large for int cell indices");
+        }
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = cols + 2;
+        size_ = static_cast<int>(padded);
+    }
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int stride_ = 0;
+    int size_ = 0;
+    const uint8_t* cells_ = nullptr;
+    std::vector<uint8_t>* owned_ = nullptr;  // cells_ storage if we own it
+    std::shared_ptr<const void> owner_;
+};
+
+// Checksum of the dimensions and the walkable/blocked state of every
+// cell. Obstacle bytes other than 1 (possible in mapped files) count as 1.
+inline uint64_t gridChecksum(const GridMap& grid) {
+    Checksum sum;
+    sum.add(static_cast<uint64_t>(grid.rows()) << 32 | static_cast<uint32_t>(grid.cols()));
+    const uint8_t* cells = grid.data();
+    const uint64_t low7 = 0x7f7f7f7f7f7f7f7full;
+    size_t i = 0, size = static_cast<size_t>(grid.size());
+    for(; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, cells + i, 8);
+        // Sets the low bit of every nonzero byte and clears the rest
+        sum.add((((word & low7) + low7) | word) >> 7 & 0x0101010101010101ull);
+    }
+    for(; i < size; i++) {
+        sum.add(static_cast<uint64_t>(cells[i] != 0));
+    }
+    return sum.value();
+}
+
+// Reads the text map format: "rows cols" followed by rows*cols
+// values of 0 (walkable) or 1 (obstacle).
+inline GridMap readGridText(std::istream& in) {
+    int rows = 0, cols = 0;
+    if(!(in >> rows >> cols) || rows <= 0 || cols <= 0) {
+        throw std::runtime_error("Invalid map dimensions.");
+    }
+
+    GridMap grid(rows, cols);
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++) {
+            int cell;
+            if(!(in >> cell)) {
+                throw std::runtime_error("Map data ended early.");
+            }
+            grid.setBlocked(r, c, cell != 0);
+        }
+    }
+    return grid;
+}
+
+#endif // GRID_MAP_H
@@ -0,0 +1,471 @@
+/*******************************************************
+ * HPA* - hierarchical pathfinding over a GridMap
+ *
+ * The map is cut into square clusters. Where two
+ * neighbouring clusters share a run of open cell pairs
+ * across their border, the run becomes an entrance: one
+ * transition in its middle, or one at each end for long
+ * runs. The cells either side of a transition are the
+ * abstract nodes. Each cluster stores the distances
+ * between its nodes, found by a Dijkstra confined to it.
+ *
+ * A query links start and goal to the nodes of their
+ * clusters, runs A* over the abstract graph (keyed by cell
+ * index, so the usual SearchContext and open sets apply),
+ * and then refines each abstract edge into cells with
+ * one more cluster-local search. Paths are usually close
+ * to optimal but not always, since they may only cross
+ * borders at transitions.
+ *
+ * Clusters are preprocessed in parallel. After cells
+ * change, invalidate() the clusters involved and update()
+ * rebuilds just those and their neighbours.
+ *******************************************************/
+
+#ifndef HPA_H
+#define HPA_H
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "grid_map.h"
+#include "parallel.h"
+#include "priority_queues.h"
+#include "search_context.h"
+
+// Entrances at least this long get a transition at each end.
+const int kHpaLongEntrance = 6;
+
+struct ClusterRect {
+    int row0, col0, rows, cols;
+
+    bool contains(int row, int col) const {
+        return row >= row0 && row < row0 + rows && col >= col0 && col < col0 + cols;
+    }
+};
+
+// Dijkstra confined to one cluster. The cluster is copied into a local
+// frame with a blocked border, so the inner loop needs no bounds checks
+// and one load() serves any number of run() calls.
+class ClusterSearch {
+public:
+    void load(const GridMap& grid, const ClusterRect& rect) {
+        rect_ = rect;
+        gridStride_ = grid.stride();
+        base_ = grid.index(rect.row0, rect.col0);
+        stride_ = rect.cols + 2;
+        int size = (rect.rows + 2) * stride_;
+        blocked_.assign(size, 1);
+        for(int r = 0; r < rect.rows; r++) {
+            const uint8_t* row = grid.data() + base_ + r * gridStride_;
+            std::copy(row, row + rect.cols, blocked_.begin() + (r + 1) * stride_ + 1);
+        }
+        dist_.resize(size);
+        parent_.resize(size);
+    }
+
+    const ClusterRect& rect() const { return rect_; }
+
+    int localIndex(int cell) const {
+        int offset = cell - base_;
+        return (offset / gridStride_ + 1) * stride_ + offset % gridStride_ + 1;
+    }
+
+    int gridIndex(int local) const {
+        return base_ + (local / stride_ - 1) * gridStride_ + local % stride_ - 1;
+    }
+
+    // Shortest costs from sourceCell (a grid cell index in the cluster).
+    void run(int sourceCell, Connectivity connectivity) {
+        const int unreached = std::numeric_limits<int>::max();
+        std::fill(dist_.begin(), dist_.end(), unreached);
+
+        const int offsets[8] = {-stride_, stride_, -1, 1,
+                                -stride_ - 1, -stride_ + 1, stride_ - 1, stride_ + 1};
+        const int numDirs = connectivity == Connectivity::Eight ? 8 : 4;
+        const int straightCost = connectivity == Connectivity::Eight ? kStraightCost8 : 1;
+
+        int source = localIndex(sourceCell);
+        dist_[source] = 0;
+        parent_[source] = -1;
+        if(connectivity == Connectivity::Four) {
+            // Unit costs: a breadth-first search settles cells in order
+            fifo_.clear();
+            fifo_.push_back(source);
+            for(size_t head = 0; head < fifo_.size(); head++) {
+                int idx = fifo_[head];
+                for(int i = 0; i < 4; i++) {
+                    int next = idx + offsets[i];
+                    if(blocked_[next] || dist_[next] != unreached) continue;
+                    dist_[next] = dist_[idx] + 1;
+                    parent_[next] = idx;
+                    fifo_.push_back(next);
+                }
+            }
+            return;
+        }
+        queue_.reset(static_cast<int>(dist_.size()));
+        queue_.push(0, source);
+        while(!queue_.empty()) {
+            auto [d, idx] = queue_.pop();
+            if(d > dist_[idx]) continue;
+            for(int i = 0; i < numDirs; i++) {
+                int next = idx + offsets[i];
+                if(blocked_[next]) continue;
+                int cost = straightCost;
+                if(i >= 4) {
+                    // Both cells the diagonal passes lie inside the cluster too
+                    int vertical = offsets[i] > 0 ? stride_ : -stride_;
+                    if(blocked_[idx + vertical] || blocked_[next - vertical]) continue;
+                    cost = kDiagonalCost8;
+                }
+                if(d + cost < dist_[next]) {
+                    dist_[next] = d + cost;
+                    parent_[next] = idx;
+                    queue_.push(d + cost, next);
+                }
+            }
+        }
+    }
+
+    // Results of the last run(), by grid cell index in the cluster.
+    int distance(int cell) const { return dist_[localIndex(cell)]; }
+    int parent(int cell) const {
+        int p = parent_[localIndex(cell)];
+        return p < 0 ? -1 : gridIndex(p);
+    }
+
+private:
+    ClusterRect rect_ = {0, 0, 0, 0};
+    int gridStride_ = 0;
+    int base_ = 0;
+    int stride_ = 0;
+    std::vector<uint8_t> blocked_;
+    std::vector<int> dist_;
+    std::vector<int> parent_;
+    std::vector<int> fifo_;
+    BucketQueue queue_;
+};
+
+class HpaGraph {
+public:
+    HpaGraph() = default;
+
+    // Partitions grid into clusterSize x clusterSize clusters and
+    // preprocesses all of them with numThreads threads (0 = all cores).
+    HpaGraph(const GridMap& grid, int clusterSize,
+             Connectivity connectivity = Connectivity::Four, int numThreads = 0)
+        : rows_(grid.rows()), cols_(grid.cols()), clusterSize_(clusterSize),
+          connectivity_(connectivity), numThreads_(numThreads)
+    {
+        if(clusterSize < 2) {
+            throw std::invalid_argument("HpaGraph: cluster size must be at least 2");
+        }
+        clusterRows_ = (rows_ + clusterSize - 1) / clusterSize;
+        clusterCols_ = (cols_ + clusterSize - 1) / clusterSize;
+        int numClusters = clusterRows_ * clusterCols_;
+        clusters_.resize(numClusters);
+        eastTransitions_.resize(numClusters);
+        southTransitions_.resize(numClusters);
+        dirty_.assign(numClusters, 1);
+        update(grid);
+    }
+
+    int clusterSize() const { return clusterSize_; }
+    Connectivity connectivity() const { return connectivity_; }
+    int numClusters() const { return static_cast<int>(clusters_.size()); }
+
+    bool matches(const GridMap& grid) const {
+        return grid.rows() == rows_ && grid.cols() == cols_;
+    }
+
+    int clusterOf(int row, int col) const {
+        return (row / clusterSize_) * clusterCols_ + col / clusterSize_;
+    }
+
+    ClusterRect clusterRect(int cluster) const {
+        int row0 = (cluster / clusterCols_) * clusterSize_;
+        int col0 = (cluster % clusterCols_) * clusterSize_;
+        return {row0, col0, std::min(clusterSize_, rows_ - row0), std::min(clusterSize_, cols_ - col0)};
+    }
+
+    // Abstract nodes of a cluster, as sorted grid cell indices.
+    const std::vector<int>& entrances(int cluster) const { return clusters_[cluster].cells; }
+
+    // Position of cell in entrances(cluster), or -1.
+    int entranceIndex(int cluster, int cell) const {
+        const std::vector<int>& cells = clusters_[cluster].cells;
+        auto it = std::lower_bound(cells.begin(), cells.end(), cell);
+        return it != cells.end() && *it == cell ? static_cast<int>(it - cells.begin()) : -1;
+    }
+
+    // Cost between entrances i and j of a cluster; INT_MAX if the
+    // cluster does not connect them.
+    int distance(int cluster, int i, int j) const {
+        const Cluster& data = clusters_[cluster];
+        return data.dist[static_cast<size_t>(i) * data.cells.size() + j];
+    }
+
+    // Cells in neighbouring clusters one step from entrance i.
+    const std::vector<int>& partners(int cluster, int i) const { return clusters_[cluster].partners[i]; }
+
+    // Marks the cluster holding (row, col) for rebuilding; call after
+    // changing that cell, then update() before the next query.
+    void invalidate(int row, int col) { dirty_[clusterOf(row, col)] = 1; }
+
+    bool needsUpdate() const {
+        return std::find(dirty_.begin(), dirty_.end(), 1) != dirty_.end();
+    }
+
+    // Rebuilds the entrances on the borders of invalidated clusters, then
+    // the node sets and distances of those clusters and their neighbours.
+    void update(const GridMap& grid) {
+        if(!matches(grid)) {
+            throw std::invalid_argument("HpaGraph does not match grid");
+        }
+        std::vector<char> rebuild(clusters_.size(), 0);
+        for(int c = 0; c < numClusters(); c++) {
+            if(!dirty_[c]) continue;
+            int cr = c / clusterCols_, cc = c % clusterCols_;
+            findTransitions(grid, c);
+            if(cc > 0) findTransitions(grid, c - 1);
+            if(cr > 0) findTransitions(grid, c - clusterCols_);
+            rebuild[c] = 1;
+            if(cc > 0) rebuild[c - 1] = 1;
+            if(cc + 1 < clusterCols_) rebuild[c + 1] = 1;
+            if(cr > 0) rebuild[c - clusterCols_] = 1;
+            if(cr + 1 < clusterRows_) rebuild[c + clusterCols_] = 1;
+        }
+        std::vector<int> work;
+        for(int c = 0; c < numClusters(); c++) {
+            if(rebuild[c]) work.push_back(c);
+        }
+        parallelFor(0, static_cast<int>(work.size()), [&](int i) {
+            buildCluster(grid, work[i]);
+        }, numThreads_);
+        std::fill(dirty_.begin(), dirty_.end(), 0);
+    }
+
+private:
+    struct Cluster {
+        std::vector<int> cells;                  // entrance cells, sorted
+        std::vector<std::vector<int>> partners;  // per entrance
+        std::vector<int> dist;                   // cells.size()^2 costs
+    };
+
+    // Transitions across the east and south borders of cluster c, as
+    // (cell in c, cell in the neighbour) pairs.
+    void findTransitions(const GridMap& grid, int c) {
+        ClusterRect rect = clusterRect(c);
+        auto scan = [&](std::vector<std::pair<int,int>>& out, int length, int first, int step, int across) {
+            out.clear();
+            int runStart = -1;
+            for(int i = 0; i <= length; i++) {
+                int cell = first + i * step;
+                bool open = i < length && !grid.blocked(cell) && !grid.blocked(cell + across);
+                if(open && runStart < 0) runStart = i;
+                if(!open && runStart >= 0) {
+                    int runLength = i - runStart;
+                    if(runLength >= kHpaLongEntrance) {
+                        int a = first + runStart * step, b = first + (i - 1) * step;
+                        out.emplace_back(a, a + across);
+                        out.emplace_back(b, b + across);
+                    } else {
+                        int m = first + (runStart + runLength / 2) * step;
+                        out.emplace_back(m, m + across);
+                    }
+                    runStart = -1;
+                }
+            }
+        };
+        eastTransitions_[c].clear();
+        southTransitions_[c].clear();
+        if(c % clusterCols_ + 1 < clusterCols_) {
+            scan(eastTransitions_[c], rect.rows, grid.index(rect.row0, rect.col0 + rect.cols - 1),
+                 grid.stride(), 1);
+        }
+        if(c / clusterCols_ + 1 < clusterRows_) {
+            scan(southTransitions_[c], rect.cols, grid.index(rect.row0 + rect.rows - 1, rect.col0),
+                 1, grid.stride());
+        }
+    }
+
+    void buildCluster(const GridMap& grid, int c) {
+        std::vector<std::pair<int,int>> links;  // (entrance, partner)
+        for(auto& t : eastTransitions_[c]) links.push_back(t);
+        for(auto& t : southTransitions_[c]) links.push_back(t);
+        if(c % clusterCols_ > 0) {
+            for(auto& t : eastTransitions_[c - 1]) links.emplace_back(t.second, t.first);
+        }
+        if(c / clusterCols_ > 0) {
+            for(auto& t : southTransitions_[c - clusterCols_]) links.emplace_back(t.second, t.first);
+        }
+
+        Cluster data;
+        for(auto& link : links) data.cells.push_back(link.first);
+        std::sort(data.cells.begin(), data.cells.end());
+        data.cells.erase(std::unique(data.cells.begin(), data.cells.end()), data.cells.end());
+        int k = static_cast<int>(data.cells.size());
+        data.partners.resize(k);
+        for(auto& link : links) {
+            int i = static_cast<int>(std::lower_bound(data.cells.begin(), data.cells.end(), link.first) -
+                                     data.cells.begin());
+            data.partners[i].push_back(link.second);
+        }
+
+        // Costs are symmetric, so each search fills a row and a column.
+        data.dist.assign(static_cast<size_t>(k) * k, 0);
+        ClusterSearch search;
+        search.load(grid, clusterRect(c));
+        for(int i = 0; i + 1 < k; i++) {
+            search.run(data.cells[i], connectivity_);
+            for(int j = i + 1; j < k; j++) {
+                int d = search.distance(data.cells[j]);
+                data.dist[static_cast<size_t>(i) * k + j] = d;
+                data.dist[static_cast<size_t>(j) * k + i] = d;
+            }
+        }
+        clusters_[c] = std::move(data);
+    }
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int clusterSize_ = 0;
+    int clusterRows_ = 0;
+    int clusterCols_ = 0;
+    Connectivity connectivity_ = Connectivity::Four;
+    int numThreads_ = 0;
+    std::vector<Cluster> clusters_;
+    std::vector<std::vector<std::pair<int,int>>> eastTransitions_;
+    std::vector<std::vector<std::pair<int,int>>> southTransitions_;
+    std::vector<char> dirty_;
+};
+
+// HPA* query. The context and open set serve the abstract search and can
+// be reused across queries like with aStarSearch. Returns every cell from
+// start to goal, or an empty path if the goal is unreachable.
+template <class OpenSet>
+std::vector<std::pair<int,int>> hpaSearch(const GridMap& grid,
+                                         const HpaGraph& graph,
+                                         SearchContext& ctx,
+                                         OpenSet& openSet,
+                                         int startRow, int startCol,
+                                         int goalRow, int goalCol)
+{
+    if(!graph.matches(grid)) {
+        throw std::invalid_argument("HpaGraph does not match grid");
+    }
+    if(graph.needsUpdate()) {
+        throw std::logic_error("HpaGraph has invalidated clusters; call update() first");
+    }
+    const Connectivity connectivity = graph.connectivity();
+    const int unreached = std::numeric_limits<int>::max();
+    const int interCost = connectivity == Connectivity::Eight ? kStraightCost8 : 1;
+
+    int startIdx = grid.index(startRow, startCol);
+    int goalIdx = grid.index(goalRow, goalCol);
+    int startCluster = graph.clusterOf(startRow, startCol);
+    int goalCluster = graph.clusterOf(goalRow, goalCol);
+
+    // Link start and goal into the abstract graph. Costs are symmetric, so
+    // one search from the goal gives every node's distance to it.
+    ClusterSearch startSearch, goalSearch;
+    startSearch.load(grid, graph.clusterRect(startCluster));
+    startSearch.run(startIdx, connectivity);
+    goalSearch.load(grid, graph.clusterRect(goalCluster));
+    goalSearch.run(goalIdx, connectivity);
+
+    ctx.checkGrid(grid);
+    ctx.beginQuery();
+    openSet.reset(grid.size());
+    ctx.update(startIdx, 0, -1);
+    openSet.push(gridHeuristic(connectivity, startRow, startCol, goalRow, goalCol), startIdx);
+
+    auto relax = [&](int from, int to, int cost) {
+        if(cost == unreached || ctx.isClosed(to)) return;
+        int tentativeGCost = ctx.g(from) + cost;
+        if(!ctx.visited(to) || tentativeGCost < ctx.g(to)) {
+            ctx.update(to, tentativeGCost, from);
+            int hCost = gridHeuristic(connectivity, grid.rowOf(to), grid.colOf(to), goalRow, goalCol);
+            openSet.push(tentativeGCost + hCost, to);
+        }
+    };
+
+    bool found = false;
+    while(!openSet.empty()) {
+        int currentIdx = openSet.pop().second;
+        if(ctx.isClosed(currentIdx))
+            continue;
+        ctx.close(currentIdx);
+        if(currentIdx == goalIdx) {
+            found = true;
+            break;
+        }
+
+        int row = grid.rowOf(currentIdx), col = grid.colOf(currentIdx);
+        int cluster = graph.clusterOf(row, col);
+        const std::vector<int>& nodes = graph.entrances(cluster);
+        if(currentIdx == startIdx) {
+            for(int node : nodes) {
+                relax(currentIdx, node, startSearch.distance(node));
+            }
+        }
+        int i = graph.entranceIndex(cluster, currentIdx);
+        if(i >= 0) {
+            for(int j = 0; j < static_cast<int>(nodes.size()); j++) {
+                if(j != i) relax(currentIdx, nodes[j], graph.distance(cluster, i, j));
+            }
+            for(int partner : graph.partners(cluster, i)) {
+                relax(currentIdx, partner, interCost);
+            }
+        }
+        if(cluster == goalCluster) {
+            relax(currentIdx, goalIdx, goalSearch.distance(currentIdx));
+        }
+    }
+    if(!found) {
+        return {}; // Return empty path to indicate failure
+    }
+
+    // Refine: border crossings are single steps, everything else stays
+    // inside one cluster and is re-searched there.
+    std::vector<int> abstractPath;
+    for(int idx = goalIdx; idx != -1; idx = ctx.parent(idx)) {
+        abstractPath.push_back(idx);
+    }
+    std::reverse(abstractPath.begin(), abstractPath.end());
+
+    std::vector<std::pair<int,int>> path;
+    path.emplace_back(startRow, startCol);
+    std::vector<int> segment;
+    ClusterSearch refine;
+    int loadedCluster = -1;
+    for(size_t k = 1; k < abstractPath.size(); k++) {
+        int from = abstractPath[k - 1], to = abstractPath[k];
+        int fromRow = grid.rowOf(from), fromCol = grid.colOf(from);
+        int cluster = graph.clusterOf(fromRow, fromCol);
+        if(cluster != graph.clusterOf(grid.rowOf(to), grid.colOf(to))) {
+            path.emplace_back(grid.rowOf(to), grid.colOf(to));
+            continue;
+        }
+        if(cluster != loadedCluster) {
+            refine.load(grid, graph.clusterRect(cluster));
+            loadedCluster = cluster;
+        }
+        refine.run(from, connectivity);
+        segment.clear();
+        for(int idx = to; idx != from; idx = refine.parent(idx)) {
+            segment.push_back(idx);
+        }
+        for(auto it = segment.rbegin(); it != segment.rend(); ++it) {
+            path.emplace_back(grid.rowOf(*it), grid.colOf(*it));
+        }
+    }
+    return path;
+}
+
+#endif // HPA_H
@@ -0,0 +1,345 @@
+/*******************************************************
+ * Jump Point Search over a GridMap
+ *
+ * JPS is A* on a uniform-cost grid that skips the
+ * symmetric paths through open areas. From each expanded
+ * cell it only scans the directions that can start an
+ * optimal path (pruning rules), and a scan runs in a
+ * straight or diagonal line until it hits a wall, the
+ * goal, or a jump point - a cell with a forced neighbour
+ * that the pruning would otherwise miss. Only jump points
+ * enter the open set, so open areas cost one expansion per
+ * turn instead of one per cell.
+ *
+ * Path costs and the returned cell-by-cell paths match
+ * aStarSearch with the same Connectivity:
+ *   Eight - diagonal moves without corner cutting; the
+ *           rules of Harabor & Grastien (2014)
+ *   Four  - cardinal moves; vertical scans also probe
+ *           horizontally, so horizontal runs are only
+ *           expanded where they branch
+ *
+ * Given a BitGrid of the map, straight scans test 64
+ * cells per word instead of one (see bit_grid.h).
+ *******************************************************/
+
+#ifndef JPS_H
+#define JPS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "bit_grid.h"
+#include "grid_map.h"
+#include "search_context.h"
+
+// Scans from idx along the cardinal offset step. side is the
+// perpendicular unit offset. Stops at the goal or at a cell where an
+// obstacle behind-and-beside the scan opens up beside it.
+inline int jpsJumpStraight(const GridMap& grid, int idx, int step, int side, int goalIdx) {
+    for(;;) {
+        idx += step;
+        if(grid.blocked(idx)) return -1;
+        if(idx == goalIdx) return idx;
+        if((!grid.blocked(idx + side) && grid.blocked(idx - step + side)) ||
+           (!grid.blocked(idx - side) && grid.blocked(idx - step - side))) {
+            return idx;
+        }
+    }
+}
+
+// 8-connected diagonal scan with vertical part v and horizontal part h.
+// A diagonal cell is a jump point if either straight scan from it finds
+// one.
+inline int jpsJumpDiagonal(const GridMap& grid, int idx, int v, int h, int goalIdx) {
+    for(;;) {
+        if(grid.blocked(idx + v) || grid.blocked(idx + h)) return -1;  // corner cutting
+        idx += v + h;
+        if(grid.blocked(idx)) return -1;
+        if(idx == goalIdx) return idx;
+        if(jpsJumpStraight(grid, idx, v, 1, goalIdx) != -1 ||
+           jpsJumpStraight(grid, idx, h, grid.stride(), goalIdx) != -1) {
+            return idx;
+        }
+    }
+}
+
+// 4-connected vertical scan: a cell is also a jump point if a
+// horizontal scan from it reaches one.
+inline int jpsJumpVertical4(const GridMap& grid, int idx, int v, int goalIdx) {
+    for(;;) {
+        idx += v;
+        if(grid.blocked(idx)) return -1;
+        if(idx == goalIdx) return idx;
+        if((!grid.blocked(idx + 1) && grid.blocked(idx - v + 1)) ||
+           (!grid.blocked(idx - 1) && grid.blocked(idx - v - 1))) {
+            return idx;
+        }
+        if(jpsJumpStraight(grid, idx, 1, grid.stride(), goalIdx) != -1 ||
+           jpsJumpStraight(grid, idx, -1, grid.stride(), goalIdx) != -1) {
+            return idx;
+        }
+    }
+}
+
+// Jump from idx in direction (dRow, dCol); returns the jump point or -1.
+inline int jpsJump(const GridMap& grid, Connectivity connectivity,
+                   int idx, int dRow, int dCol, int goalIdx)
+{
+    int v = dRow * grid.stride();
+    if(dRow != 0 && dCol != 0) {
+        return jpsJumpDiagonal(grid, idx, v, dCol, goalIdx);
+    }
+    if(dRow == 0) {
+        return jpsJumpStraight(grid, idx, dCol, grid.stride(), goalIdx);
+    }
+    if(connectivity == Connectivity::Four) {
+        return jpsJumpVertical4(grid, idx, v, goalIdx);
+    }
+    return jpsJumpStraight(grid, idx, v, 1, goalIdx);
+}
+
+// Bit-parallel jpsJumpStraight for the cardinal direction (dRow, dCol):
+// one bitScanStraight over the row, or over the column in the
+// transposed masks, then a check for the goal on the scanned stretch.
+inline int jpsJumpStraightBits(const BitGrid& bits, int idx, int dRow, int dCol, int goalIdx) {
+    int stride = bits.stride();
+    int r = idx / stride, c = idx % stride;
+    int stopIdx;
+    bool wall;
+    bool goalInLine;
+    if(dRow == 0) {
+        const uint64_t* line = bits.row(r);
+        int x = bitScanStraight(line, bits.row(r - 1), bits.row(r + 1), c, dCol);
+        stopIdx = r * stride + x;
+        wall = (line[x >> 6] >> (x & 63)) & 1;
+        goalInLine = goalIdx / stride == r;
+    } else {
+        const uint64_t* line = bits.column(c);
+        int y = bitScanStraight(line, bits.column(c - 1), bits.column(c + 1), r, dRow);
+        stopIdx = y * stride + c;
+        wall = (line[y >> 6] >> (y & 63)) & 1;
+        goalInLine = goalIdx % stride == c;
+    }
+    if(goalInLine) {
+        int step = dRow * stride + dCol;
+        int goalSteps = (goalIdx - idx) / step;
+        if(goalSteps > 0 && goalSteps <= (stopIdx - idx) / step) return goalIdx;
+    }
+    return wall ? -1 : stopIdx;
+}
+
+// jpsJumpDiagonal with bit-parallel straight probes.
+inline int jpsJumpDiagonalBits(const GridMap& grid, const BitGrid& bits,
+                               int idx, int dRow, int dCol, int goalIdx)
+{
+    int v = dRow * grid.stride(), h = dCol;
+    for(;;) {
+        if(grid.blocked(idx + v) || grid.blocked(idx + h)) return -1;  // corner cutting
+        idx += v + h;
+        if(grid.blocked(idx)) return -1;
+        if(idx == goalIdx) return idx;
+        if(jpsJumpStraightBits(bits, idx, dRow, 0, goalIdx) != -1 ||
+           jpsJumpStraightBits(bits, idx, 0, dCol, goalIdx) != -1) {
+            return idx;
+        }
+    }
+}
+
+// jpsJumpVertical4 with bit-parallel scans. The vertical scan finds the
+// first wall, forced cell or goal in one go; only the cells before it
+// still need their horizontal probes.
+inline int jpsJumpVertical4Bits(const GridMap& grid, const BitGrid& bits,
+                                int idx, int dRow, int goalIdx)
+{
+    int v = dRow * grid.stride();
+    int stopIdx = jpsJumpStraightBits(bits, idx, dRow, 0, goalIdx);
+    for(;;) {
+        idx += v;
+        if(idx == stopIdx) return idx;
+        if(grid.blocked(idx)) return -1;
+        if(jpsJumpStraightBits(bits, idx, 0, 1, goalIdx) != -1 ||
+           jpsJumpStraightBits(bits, idx, 0, -1, goalIdx) != -1) {
+            return idx;
+        }
+    }
+}
+
+// jpsJump using the bit-packed masks for every straight scan.
+inline int jpsJumpBits(const GridMap& grid, const BitGrid& bits, Connectivity connectivity,
+                       int idx, int dRow, int dCol, int goalIdx)
+{
+    if(dRow != 0 && dCol != 0) {
+        return jpsJumpDiagonalBits(grid, bits, idx, dRow, dCol, goalIdx);
+    }
+    if(dRow != 0 && connectivity == Connectivity::Four) {
+        return jpsJumpVertical4Bits(grid, bits, idx, dRow, goalIdx);
+    }
+    return jpsJumpStraightBits(bits, idx, dRow, dCol, goalIdx);
+}
+
+// Fills dirs with the directions worth scanning from idx when it was
+// reached moving (dRow, dCol) (both 0 at the start). Returns the count.
+inline int jpsSuccessorDirections(const GridMap& grid, Connectivity connectivity,
+                                  int idx, int dRow, int dCol, int dirs[8][2])
+{
+    int count = 0;
+    auto add = [&](int r, int c) {
+        dirs[count][0] = r;
+        dirs[count][1] = c;
+        count++;
+    };
+
+    if(dRow == 0 && dCol == 0) {
+        for(int r = -1; r <= 1; r++) {
+            for(int c = -1; c <= 1; c++) {
+                if((r != 0 || c != 0) && (connectivity == Connectivity::Eight || r == 0 || c == 0)) {
+                    add(r, c);
+                }
+            }
+        }
+        return count;
+    }
+
+    int stride = grid.stride();
+    if(connectivity == Connectivity::Four) {
+        add(dRow, dCol);
+        if(dRow == 0) {
+            add(-1, 0);
+            add(1, 0);
+        } else {
+            add(0, -1);
+            add(0, 1);
+        }
+        return count;
+    }
+
+    if(dRow != 0 && dCol != 0) {
+        add(dRow, 0);
+        add(0, dCol);
+        add(dRow, dCol);
+    } else if(dRow != 0) {
+        add(dRow, 0);
+        for(int s = -1; s <= 1; s += 2) {
+            if(!grid.blocked(idx + s) && grid.blocked(idx - dRow * stride + s)) {
+                add(0, s);
+                add(dRow, s);
+            }
+        }
+    } else {
+        add(0, dCol);
+        for(int s = -1; s <= 1; s += 2) {
+            if(!grid.blocked(idx + s * stride) && grid.blocked(idx - dCol + s * stride)) {
+                add(s, 0);
+                add(s, dCol);
+            }
+        }
+    }
+    return count;
+}
+
+// The JPS main loop; jump(idx, dRow, dCol, goalIdx) performs the scans.
+template <class OpenSet, class Jump>
+std::vector<std::pair<int,int>> jpsSearch(const GridMap& grid,
+                                         SearchContext& ctx,
+                                         OpenSet& openSet,
+                                         int startRow, int startCol,
+                                         int goalRow, int goalCol,
+                                         Connectivity connectivity,
+                                         Jump jump)
+{
+    ctx.checkGrid(grid);
+    ctx.beginQuery();
+    openSet.reset(grid.size());
+
+    int startIdx = grid.index(startRow, startCol);
+    int goalIdx = grid.index(goalRow, goalCol);
+    ctx.update(startIdx, 0, -1);
+    openSet.push(gridHeuristic(connectivity, startRow, startCol, goalRow, goalCol), startIdx);
+
+    const bool eight = connectivity == Connectivity::Eight;
+    int dirs[8][2];
+
+    while(!openSet.empty()) {
+        int currentIdx = openSet.pop().second;
+        if(ctx.isClosed(currentIdx))
+            continue;
+        ctx.close(currentIdx);
+
+        if(currentIdx == goalIdx) {
+            return tracePath(grid, ctx, goalIdx);
+        }
+
+        int row = grid.rowOf(currentIdx);
+        int col = grid.colOf(currentIdx);
+        int dRow = 0, dCol = 0;
+        int parent = ctx.parent(currentIdx);
+        if(parent != -1) {
+            int parentRow = grid.rowOf(parent), parentCol = grid.colOf(parent);
+            dRow = (row > parentRow) - (row < parentRow);
+            dCol = (col > parentCol) - (col < parentCol);
+        }
+
+        int count = jpsSuccessorDirections(grid, connectivity, currentIdx, dRow, dCol, dirs);
+        for(int i = 0; i < count; i++) {
+            int jumpIdx = jump(currentIdx, dirs[i][0], dirs[i][1], goalIdx);
+            if(jumpIdx == -1 || ctx.isClosed(jumpIdx)) continue;
+
+            int jumpRow = grid.rowOf(jumpIdx), jumpCol = grid.colOf(jumpIdx);
+            int steps = std::max(std::abs(jumpRow - row), std::abs(jumpCol - col));
+            int stepCost = !eight ? 1 : (dirs[i][0] != 0 && dirs[i][1] != 0) ? kDiagonalCost8
+                                                                           : kStraightCost8;
+            int tentativeGCost = ctx.g(currentIdx) + steps * stepCost;
+            if(!ctx.visited(jumpIdx) || tentativeGCost < ctx.g(jumpIdx)) {
+                ctx.update(jumpIdx, tentativeGCost, currentIdx);
+                int hCost = gridHeuristic(connectivity, jumpRow, jumpCol, goalRow, goalCol);
+                openSet.push(tentativeGCost + hCost, jumpIdx);
+            }
+        }
+    }
+
+    return {}; // Return empty path to indicate failure
+}
+
+// Jump Point Search. Same contract as aStarSearch: the context and open
+// set can be reused across queries on this grid, and the returned path
+// lists every cell from start to goal.
+template <class OpenSet>
+std::vector<std::pair<int,int>> jumpPointSearch(const GridMap& grid,
+                                               SearchContext& ctx,
+                                               OpenSet& openSet,
+                                               int startRow, int startCol,
+                                               int goalRow, int goalCol,
+                                               Connectivity connectivity = Connectivity::Eight)
+{
+    return jpsSearch(grid, ctx, openSet, startRow, startCol, goalRow, goalCol, connectivity,
+                     [&](int idx, int dRow, int dCol, int goalIdx) {
+                         return jpsJump(grid, connectivity, idx, dRow, dCol, goalIdx);
+                     });
+}
+
+// Jump Point Search with bit-parallel scans; bits must be built from grid.
+template <class OpenSet>
+std::vector<std::pair<int,int>> jumpPointSearch(const GridMap& grid,
+                                               const BitGrid& bits,
+                                               SearchContext& ctx,
+                                               OpenSet& openSet,
+                                               int startRow, int startCol,
+                                               int goalRow, int goalCol,
+                                               Connectivity connectivity = Connectivity::Eight)
+{
+    if(!bits.matches(grid)) {
+        throw std::invalid_argument("BitGrid does not match grid");
+    }
+    return jpsSearch(grid, ctx, openSet, startRow, startCol, goalRow, goalCol, connectivity,
+                     [&](int idx, int dRow, int dCol, int goalIdx) {
+                         return jpsJumpBits(grid, bits, connectivity, idx, dRow, dCol, goalIdx);
+                     });
+}
+
+#endif // JPS_H
@@ -0,0 +1,368 @@
+/*******************************************************
+ * JPS+ - Jump Point Search with precomputed jump distances
+ *
+ * For a static map, every scan JPS performs at query time
+ * can be answered ahead of time. JpsPlusTable stores, for
+ * each cell and direction, a signed 16-bit distance:
+ *   d > 0  the d-th cell in that direction is a jump point
+ *   d <= 0 no jump point; -d free cells before a wall
+ * Runs longer than 32767 cells are split by a pseudo jump
+ * point, which is harmless: expanding any cell with the
+ * JPS pruning rules is still optimal.
+ *
+ * Queries then replace each scan with one table lookup
+ * plus a goal test (the goal may lie on the ray, or on the
+ * row/column a diagonal or 4-connected vertical ray
+ * crosses). Paths have the same cost as jumpPointSearch.
+ *
+ * Tables are built in parallel and can be written next to
+ * the map and memory-mapped back, like grid_file.h. The
+ * file records a checksum of the map's cells, so a table
+ * left over from an edited map is refused on load.
+ *******************************************************/
+
+#ifndef JPS_PLUS_H
+#define JPS_PLUS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "grid_map.h"
+#include "jps.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "search_context.h"
+
+// Direction order shared with aStarSearch: up, down, left, right, then
+// up-left, up-right, down-left, down-right.
+const int kJpsDirRow[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+const int kJpsDirCol[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+inline int jpsDirectionIndex(int dRow, int dCol) {
+    if(dCol == 0) return dRow < 0 ? 0 : 1;
+    if(dRow == 0) return dCol < 0 ? 2 : 3;
+    return 4 + (dRow > 0 ? 2 : 0) + (dCol > 0 ? 1 : 0);
+}
+
+class JpsPlusTable {
+public:
+    static const int kMaxDistance = 32767;
+
+    JpsPlusTable() = default;
+
+    // Views a distance array kept alive by owner (e.g. a mapped file).
+    JpsPlusTable(int rows, int cols, Connectivity connectivity,
+                 const int16_t* distances, std::shared_ptr<const void> owner)
+        : rows_(rows), cols_(cols), connectivity_(connectivity),
+          distances_(distances), owner_(std::move(owner))
+    {}
+
+    // Precomputes the table for grid using numThreads threads (0 = all cores).
+    static JpsPlusTable build(const GridMap& grid, Connectivity connectivity, int numThreads = 0);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    Connectivity connectivity() const { return connectivity_; }
+    int numDirections() const { return connectivity_ == Connectivity::Eight ? 8 : 4; }
+
+    bool matches(const GridMap& grid) const {
+        return distances_ != nullptr && grid.rows() == rows_ && grid.cols() == cols_;
+    }
+
+    int distance(int idx, int dir) const {
+        return distances_[static_cast<size_t>(idx) * numDirections() + dir];
+    }
+
+    // All distances, numDirections() per padded grid cell.
+    const int16_t* data() const { return distances_; }
+
+private:
+    int rows_ = 0;
+    int cols_ = 0;
+    Connectivity connectivity_ = Connectivity::Eight;
+    const int16_t* distances_ = nullptr;
+    std::shared_ptr<const void> owner_;
+};
+
+// Distance from a cell whose next cell n continues a run that had
+// distance next at n (see the table description).
+inline int16_t jpsPlusExtend(int next) {
+    int value = next > 0 ? next + 1 : next - 1;
+    if(value > JpsPlusTable::kMaxDistance || value < -JpsPlusTable::kMaxDistance) {
+        return 1;  // pseudo jump point at n
+    }
+    return static_cast<int16_t>(value);
+}
+
+inline JpsPlusTable JpsPlusTable::build(const GridMap& grid, Connectivity connectivity,
+                                        int numThreads)
+{
+    const int numDirs = connectivity == Connectivity::Eight ? 8 : 4;
+    const int stride = grid.stride();
+    const int rows = grid.rows(), cols = grid.cols();
+    auto storage = std::make_shared<std::vector<int16_t>>(static_cast<size_t>(grid.size()) * numDirs, 0);
+    int16_t* dist = storage->data();
+    auto at = [&](int idx, int dir) -> int16_t& {
+        return dist[static_cast<size_t>(idx) * numDirs + dir];
+    };
+
+    // Straight runs for one line of cells, walked against the direction so
+    // each cell extends the value of the cell it moves into.
+    auto straight = [&](int dir, int first, int count, int walk) {
+        int step = kJpsDirRow[dir] * stride + kJpsDirCol[dir];
+        int side = kJpsDirRow[dir] != 0 ? 1 : stride;
+        bool probeHorizontal = connectivity == Connectivity::Four && kJpsDirRow[dir] != 0;
+        for(int i = 0, idx = first; i < count; i++, idx += walk) {
+            if(grid.blocked(idx)) continue;
+            int n = idx + step;
+            int16_t value;
+            if(grid.blocked(n)) {
+                value = 0;
+            } else if((!grid.blocked(n + side) && grid.blocked(n - step + side)) ||
+                      (!grid.blocked(n - side) && grid.blocked(n - step - side)) ||
+                      (probeHorizontal && (at(n, 2) > 0 || at(n, 3) > 0))) {
+                value = 1;
+            } else {
+                value = jpsPlusExtend(at(n, dir));
+            }
+            at(idx, dir) = value;
+        }
+    };
+
+    // Horizontal runs first: 4-connected vertical runs probe them.
+    parallelFor(0, rows, [&](int r) {
+        straight(2, grid.index(r, 0), cols, 1);          // left
+        straight(3, grid.index(r, cols - 1), cols, -1);  // right
+    }, numThreads);
+    parallelFor(0, cols, [&](int c) {
+        straight(0, grid.index(0, c), rows, stride);          // up
+        straight(1, grid.index(rows - 1, c), rows, -stride);  // down
+    }, numThreads);
+
+    if(connectivity == Connectivity::Eight) {
+        for(int dir = 4; dir < 8; dir++) {
+            int dRow = kJpsDirRow[dir], dCol = kJpsDirCol[dir];
+            int v = dRow * stride, h = dCol;
+            int vertDir = jpsDirectionIndex(dRow, 0), horizDir = jpsDirectionIndex(0, dCol);
+            int lastRow = dRow > 0 ? rows - 1 : 0;
+            int lastCol = dCol > 0 ? cols - 1 : 0;
+            // One diagonal line per cell on the exit edges, walked backwards.
+            parallelFor(0, rows + cols - 1, [&](int line) {
+                int r, c;
+                if(line < cols) {
+                    r = lastRow;
+                    c = line;
+                } else {
+                    r = (dRow > 0 ? 0 : 1) + (line - cols);
+                    c = lastCol;
+                }
+                for(; r >= 0 && r < rows && c >= 0 && c < cols; r -= dRow, c -= dCol) {
+                    int idx = grid.index(r, c);
+                    if(grid.blocked(idx)) continue;
+                    int n = idx + v + h;
+                    int16_t value;
+                    if(grid.blocked(idx + v) || grid.blocked(idx + h) || grid.blocked(n)) {
+                        value = 0;
+                    } else if(at(n, vertDir) > 0 || at(n, horizDir) > 0) {
+                        value = 1;
+                    } else {
+                        value = jpsPlusExtend(at(n, dir));
+                    }
+                    at(idx, dir) = value;
+                }
+            }, numThreads);
+        }
+    }
+
+    const int16_t* data = storage->data();
+    return JpsPlusTable(rows, cols, connectivity, data, std::move(storage));
+}
+
+// JPS+ query. Same contract as jumpPointSearch; table must have been
+// built for this grid and fixes the connectivity.
+template <class OpenSet>
+std::vector<std::pair<int,int>> jpsPlusSearch(const GridMap& grid,
+                                             const JpsPlusTable& table,
+                                             SearchContext& ctx,
+                                             OpenSet& openSet,
+                                             int startRow, int startCol,
+                                             int goalRow, int goalCol)
+{
+    if(!table.matches(grid)) {
+        throw std::invalid_argument("JpsPlusTable does not match grid");
+    }
+    const Connectivity connectivity = table.connectivity();
+    const bool eight = connectivity == Connectivity::Eight;
+
+    ctx.checkGrid(grid);
+    ctx.beginQuery();
+    openSet.reset(grid.size());
+
+    int startIdx = grid.index(startRow, startCol);
+    int goalIdx = grid.index(goalRow, goalCol);
+    ctx.update(startIdx, 0, -1);
+    openSet.push(gridHeuristic(connectivity, startRow, startCol, goalRow, goalCol), startIdx);
+
+    int dirs[8][2];
+
+    while(!openSet.empty()) {
+        int currentIdx = openSet.pop().second;
+        if(ctx.isClosed(currentIdx))
+            continue;
+        ctx.close(currentIdx);
+
+        if(currentIdx == goalIdx) {
+            return tracePath(grid, ctx, goalIdx);
+        }
+
+        int row = grid.rowOf(currentIdx);
+        int col = grid.colOf(currentIdx);
+        int dRow = 0, dCol = 0;
+        int parent = ctx.parent(currentIdx);
+        if(parent != -1) {
+            int parentRow = grid.rowOf(parent), parentCol = grid.colOf(parent);
+            dRow = (row > parentRow) - (row < parentRow);
+            dCol = (col > parentCol) - (col < parentCol);
+        }
+        int toGoalRow = goalRow - row, toGoalCol = goalCol - col;
+        int goalSignRow = (toGoalRow > 0) - (toGoalRow < 0);
+        int goalSignCol = (toGoalCol > 0) - (toGoalCol < 0);
+
+        int count = jpsSuccessorDirections(grid, connectivity, currentIdx, dRow, dCol, dirs);
+        for(int i = 0; i < count; i++) {
+            int r = dirs[i][0], c = dirs[i][1];
+            int dist = table.distance(currentIdx, jpsDirectionIndex(r, c));
+            int reach = std::abs(dist);
+
+            // A scan stops early where it reaches the goal, or for rays that
+            // probe sideways (diagonals, 4-connected verticals) where it
+            // crosses the goal's row or column.
+            int steps = 0;
+            if(r != 0 && (c != 0 || !eight)) {
+                if(goalSignRow == r && (c == 0 || goalSignCol == c)) {
+                    int m = c == 0 ? std::abs(toGoalRow)
+                                   : std::min(std::abs(toGoalRow), std::abs(toGoalCol));
+                    if(m <= reach) steps = m;
+                }
+            } else if(r != 0 ? (toGoalCol == 0 && goalSignRow == r)
+                             : (toGoalRow == 0 && goalSignCol == c)) {
+                int m = std::abs(toGoalRow) + std::abs(toGoalCol);
+                if(m <= reach) steps = m;
+            }
+            if(steps == 0) {
+                if(dist <= 0) continue;
+                steps = dist;
+            }
+
+            int jumpIdx = currentIdx + steps * (r * grid.stride() + c);
+            if(ctx.isClosed(jumpIdx)) continue;
+
+            int stepCost = !eight ? 1 : (r != 0 && c != 0) ? kDiagonalCost8 : kStraightCost8;
+            int tentativeGCost = ctx.g(currentIdx) + steps * stepCost;
+            if(!ctx.visited(jumpIdx) || tentativeGCost < ctx.g(jumpIdx)) {
+                ctx.update(jumpIdx, tentativeGCost, currentIdx);
+                int hCost = gridHeuristic(connectivity, row + steps * r, col + steps * c,
+                                          goalRow, goalCol);
+                openSet.push(tentativeGCost + hCost, jumpIdx);
+            }
+        }
+    }
+
+    return {}; // Return empty path to indicate failure
+}
+
+/*
+ * Table files: a 40-byte header followed by the int16 distances exactly
+ * as JpsPlusTable stores them (host byte order).
+ */
+struct JpsPlusFileHeader {
+    char magic[8];         // "JPSPLUS1"
+    uint32_t version;      // kJpsPlusFileVersion
+    uint32_t byteOrder;    // kJpsPlusFileByteOrder as written by the producer
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t directions;   // 4 or 8
+    uint32_t reserved;
+    uint64_t gridChecksum; // gridChecksum() of the map the table was built for
+};
+
+static_assert(sizeof(JpsPlusFileHeader) == 40, "JpsPlusFileHeader must stay 40 bytes");
+
+const char kJpsPlusFileMagic[8] = {'J', 'P', 'S', 'P', 'L', 'U', 'S', '1'};
+const uint32_t kJpsPlusFileVersion = 2;
+const uint32_t kJpsPlusFileByteOrder = 0x01020304;
+
+// Writes table, built for grid, to path. Throws on I/O errors.
+inline void writeJpsPlusFile(const std::string& path, const JpsPlusTable& table, const GridMap& grid) {
+    if(!table.matches(grid)) {
+        throw std::invalid_argument("writeJpsPlusFile: table does not match grid");
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        throw std::runtime_error("Could not create " + path);
+    }
+    JpsPlusFileHeader header;
+    std::memcpy(header.magic, kJpsPlusFileMagic, sizeof(header.magic));
+    header.version = kJpsPlusFileVersion;
+    header.byteOrder = kJpsPlusFileByteOrder;
+    header.rows = static_cast<uint32_t>(table.rows());
+    header.cols = static_cast<uint32_t>(table.cols());
+    header.directions = static_cast<uint32_t>(table.numDirections());
+    header.reserved = 0;
+    header.gridChecksum = gridChecksum(grid);
+    uint64_t cells = static_cast<uint64_t>(table.rows() + 2) * (table.cols() + 2);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), cells * table.numDirections() * 2);
+    if(!out.flush()) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
+
+// Maps a table written by writeJpsPlusFile; throws unless it was built
+// for a map with exactly the cells of grid.
+inline JpsPlusTable mapJpsPlusFile(const std::string& path, const GridMap& grid) {
+    auto file = std::make_shared<MappedFile>(path);
+    if(file->size() < sizeof(JpsPlusFileHeader)) {
+        throw std::runtime_error(path + " is too small to be a JPS+ table");
+    }
+    JpsPlusFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(std::memcmp(header.magic, kJpsPlusFileMagic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error(path + " is not a JPS+ table");
+    }
+    if(header.byteOrder != kJpsPlusFileByteOrder) {
+        throw std::runtime_error(path + " was written with a different byte order");
+    }
+    if(header.version != kJpsPlusFileVersion) {
+        throw std::runtime_error(path + " has unsupported JPS+ table version " +
+                                 std::to_string(header.version));
+    }
+    if(header.rows != static_cast<uint32_t>(grid.rows()) ||
+       header.cols != static_cast<uint32_t>(grid.cols())) {
+        throw std::runtime_error(path + " was built for a different map");
+    }
+    if((header.directions != 4 && header.directions != 8) ||
+       file->size() != sizeof(JpsPlusFileHeader) +
+                       static_cast<uint64_t>(grid.size()) * header.directions * 2) {
+        throw std::runtime_error(path + " has an inconsistent size");
+    }
+    // A stale table would jump through cells that are walls now
+    if(header.gridChecksum != gridChecksum(grid)) {
+        throw std::runtime_error(path + " was built for a different version of this map");
+    }
+    auto distances = reinterpret_cast<const int16_t*>(file->data() + sizeof(JpsPlusFileHeader));
+    return JpsPlusTable(grid.rows(), grid.cols(),
+                        header.directions == 8 ? Connectivity::Eight : Connectivity::Four,
+                        distances, std::move(file));
+}
+
+#endif // JPS_PLUS_H
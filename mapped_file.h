@@ -0,0 +1,68 @@
+/*******************************************************
+ * MappedFile - read-only memory mapping of a whole file
+ *
+ * Used by the binary graph and map loaders. Pages are
+ * mapped MAP_SHARED, so every process that maps the same
+ * file shares one copy in the page cache, and nothing is
+ * read from disk until it is touched. POSIX only.
+ *******************************************************/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::runtime_error("Could not open " + path + ": " + std::strerror(errno));
+        }
+        struct stat st;
+        if(::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + path + ": " + std::strerror(err));
+        }
+        if(st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error(path + " is empty");
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);  // the mapping keeps the file referenced
+        if(addr == MAP_FAILED) {
+            throw std::runtime_error("Could not map " + path + ": " + std::strerror(err));
+        }
+        data_ = static_cast<const uint8_t*>(addr);
+    }
+
+    ~MappedFile() {
+        if(data_ != nullptr) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // MAPPED_FILE_H
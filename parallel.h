@@ -0,0 +1,317 @@
+/*******************************************************
+ * Minimal thread helpers for the preprocessing passes
+ *
+ * parallelFor runs fn(i) for every i in [begin, end) on a
+ * few std::threads. Work is handed out in small chunks
+ * from a shared counter, so uneven iterations still keep
+ * every thread busy. WorkerPool does the same on threads
+ * that are started once and then sleep between jobs, for
+ * callers that submit many short jobs. Its forEachStealing
+ * schedules by work stealing instead, for iterations whose
+ * costs differ by orders of magnitude, and forEachWorker
+ * runs one call per worker, for jobs that are split into
+ * a fixed number of cooperating parts. Compile with
+ * -pthread.
+ *******************************************************/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use when the caller passes 0.
+inline int defaultThreadCount() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+// Calls fn(worker, i) for each i in [begin, end), in no particular order,
+// on numThreads threads (0 = one per core). worker is the index of the
+// calling thread in [0, numThreads), for per-thread scratch state.
+// Iterations must be independent. The first exception thrown by fn is
+// rethrown once all threads finish.
+template <class Fn>
+void parallelForWorkers(int begin, int end, int numThreads, Fn fn) {
+    if(begin >= end) return;
+    if(numThreads <= 0) numThreads = defaultThreadCount();
+    int count = end - begin;
+    numThreads = std::min(numThreads, count);
+    if(numThreads == 1) {
+        for(int i = begin; i < end; i++) fn(0, i);
+        return;
+    }
+
+    const int chunk = std::max(1, count / (numThreads * 16));
+    std::atomic<int> next(begin);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&](int id) {
+        try {
+            for(;;) {
+                int first = next.fetch_add(chunk);
+                if(first >= end) break;
+                int last = std::min(end, first + chunk);
+                for(int i = first; i < last; i++) fn(id, i);
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error) error = std::current_exception();
+            next.store(end);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for(int t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+// Calls fn(i) for each i in [begin, end), in no particular order, using up
+// to numThreads threads (0 = one per core). Iterations must be independent.
+// The first exception thrown by fn is rethrown once all threads finish.
+template <class Fn>
+void parallelFor(int begin, int end, Fn fn, int numThreads = 0) {
+    parallelForWorkers(begin, end, numThreads, [&](int, int i) { fn(i); });
+}
+
+// What one worker did during WorkerPool::forEachStealing. busySeconds is
+// the time spent inside fn; idleSeconds is the rest of the job's wall
+// time, spent looking for work or waiting for the others to finish.
+struct WorkerStats {
+    int tasks = 0;
+    int steals = 0;
+    double busySeconds = 0;
+    double idleSeconds = 0;
+};
+
+// A fixed set of worker threads. forEach hands out iterations the same
+// way as parallelForWorkers; the calling thread joins in as worker 0, so
+// a pool of size 1 starts no threads at all. One job runs at a time.
+class WorkerPool {
+public:
+    explicit WorkerPool(int numThreads = 0)
+        : size_(numThreads <= 0 ? defaultThreadCount() : numThreads)
+    {
+        threads_.reserve(size_ - 1);
+        for(int t = 1; t < size_; t++) {
+            threads_.emplace_back([this, t] { workerLoop(t); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for(auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    int size() const { return size_; }
+
+    // Calls fn(worker, i) for each i in [begin, end) and returns once all
+    // calls are done. worker is in [0, size()). The first exception thrown
+    // by fn is rethrown.
+    template <class Fn>
+    void forEach(int begin, int end, Fn fn) {
+        if(begin >= end) return;
+        const int chunk = std::max(1, (end - begin) / (size_ * 16));
+        std::atomic<int> next(begin);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        std::function<void(int)> job = [&](int worker) {
+            try {
+                for(;;) {
+                    int first = next.fetch_add(chunk);
+                    if(first >= end) break;
+                    int last = std::min(end, first + chunk);
+                    for(int i = first; i < last; i++) fn(worker, i);
+                }
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error) error = std::current_exception();
+                next.store(end);
+            }
+        };
+        runJob(job);
+        if(error) std::rethrow_exception(error);
+    }
+
+    // Calls fn(worker) once for every worker in [0, size()), all at the
+    // same time, and returns once all calls are done. The calls may wait
+    // for each other. The first exception thrown by fn is rethrown.
+    template <class Fn>
+    void forEachWorker(Fn fn) {
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        std::function<void(int)> job = [&](int worker) {
+            try {
+                fn(worker);
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error) error = std::current_exception();
+            }
+        };
+        runJob(job);
+        if(error) std::rethrow_exception(error);
+    }
+
+    // Same contract as forEach, scheduled by work stealing: each worker
+    // starts with an equal block of iterations and takes them one at a
+    // time from the front; a worker that runs dry steals the back half of
+    // another worker's remaining block. A block of expensive iterations is
+    // thus shared out instead of holding up the worker that drew it. If
+    // stats is given, it receives one entry per worker.
+    template <class Fn>
+    void forEachStealing(int begin, int end, Fn fn, std::vector<WorkerStats>* stats = nullptr) {
+        using Clock = std::chrono::steady_clock;
+        if(stats) stats->assign(size_, WorkerStats());
+        if(begin >= end) return;
+
+        // Each worker's deque is the range [first, last) of iterations it
+        // still owns, packed into one word so both ends move by CAS. Ranges
+        // are only ever split, never merged, so a packed value cannot come
+        // back and the CAS has no ABA problem.
+        struct alignas(64) Deque {
+            std::atomic<uint64_t> range;
+        };
+        auto pack = [](int first, int last) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) | static_cast<uint32_t>(last);
+        };
+        auto first = [](uint64_t range) { return static_cast<int>(range >> 32); };
+        auto last = [](uint64_t range) { return static_cast<int>(range & 0xffffffff); };
+
+        std::vector<Deque> deques(size_);
+        int count = end - begin;
+        for(int w = 0; w < size_; w++) {
+            deques[w].range.store(pack(begin + static_cast<int>(static_cast<int64_t>(count) * w / size_),
+                                       begin + static_cast<int>(static_cast<int64_t>(count) * (w + 1) / size_)));
+        }
+        std::vector<WorkerStats> local(size_);
+        std::atomic<bool> failed(false);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        Clock::time_point start = Clock::now();
+
+        std::function<void(int)> job = [&](int worker) {
+            WorkerStats& mine = local[worker];
+            std::atomic<uint64_t>& own = deques[worker].range;
+            try {
+                while(!failed.load(std::memory_order_relaxed)) {
+                    // Take the front iteration of our own block
+                    uint64_t range = own.load();
+                    int i = first(range);
+                    if(i < last(range)) {
+                        if(!own.compare_exchange_weak(range, pack(i + 1, last(range)))) continue;
+                        Clock::time_point before = Clock::now();
+                        fn(worker, i);
+                        mine.busySeconds += std::chrono::duration<double>(Clock::now() - before).count();
+                        mine.tasks++;
+                        continue;
+                    }
+                    // Out of work: steal the back half of someone's block
+                    bool stole = false;
+                    for(int k = 1; k < size_ && !stole; k++) {
+                        std::atomic<uint64_t>& victim = deques[(worker + k) % size_].range;
+                        uint64_t theirs = victim.load();
+                        while(first(theirs) < last(theirs)) {
+                            int take = (last(theirs) - first(theirs) + 1) / 2;
+                            int split = last(theirs) - take;
+                            if(victim.compare_exchange_weak(theirs, pack(first(theirs), split))) {
+                                own.store(pack(split, last(theirs)));
+                                mine.steals++;
+                                stole = true;
+                                break;
+                            }
+                        }
+                    }
+                    // Blocks only shrink, except a thief's own one while it
+                    // holds the stolen part, so nothing is left to take
+                    if(!stole) break;
+                }
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error) error = std::current_exception();
+                failed.store(true);
+            }
+        };
+        runJob(job);
+        if(stats) {
+            double wall = std::chrono::duration<double>(Clock::now() - start).count();
+            for(int w = 0; w < size_; w++) {
+                local[w].idleSeconds = std::max(0.0, wall - local[w].busySeconds);
+            }
+            *stats = local;
+        }
+        if(error) std::rethrow_exception(error);
+    }
+
+private:
+    // Runs job(worker) once on every worker and waits for all of them.
+    void runJob(const std::function<void(int)>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            busy_ = size_ - 1;
+            generation_++;
+        }
+        wake_.notify_all();
+        job(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return busy_ == 0; });
+        job_ = nullptr;
+    }
+
+    void workerLoop(int worker) {
+        uint64_t seen = 0;
+        for(;;) {
+            const std::function<void(int)>* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if(stopping_) return;
+                seen = generation_;
+                job = job_;
+            }
+            (*job)(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                busy_--;
+            }
+            done_.notify_one();
+        }
+    }
+
+    int size_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(int)>* job_ = nullptr;
+    uint64_t generation_ = 0;
+    int busy_ = 0;
+    bool stopping_ = false;
+};
+
+#endif // PARALLEL_H
@@ -0,0 +1,279 @@
+/*******************************************************
+ * Parallel bidirectional search - one thread per side
+ *
+ * The forward and backward searches of a bidirectional
+ * query run at the same time, the backward one on a
+ * second thread. That thread belongs to the search object
+ * (a two-worker WorkerPool) and sleeps between queries,
+ * so a query pays for a wake-up, not a thread start. The
+ * sides share only three things, all of them atomics, so
+ * neither side ever waits for the other:
+ *   labels  - each side's tentative cost per vertex,
+ *             packed with the query stamp into 64 bits.
+ *             A side writes only its own labels and reads
+ *             the other's to detect meetings.
+ *   best    - the cheapest route found so far and the
+ *             vertex it runs through, packed the same way
+ *             and lowered with compare-and-swap.
+ *   keys    - the last key each side popped.
+ * A side stops once its key plus the other's last key
+ * reaches the best route. Keys never decrease, so a stale
+ * view of the other side only delays the stop; it cannot
+ * end the search too early. Labels are written and read
+ * sequentially consistent, so for two adjacent vertices
+ * settled by different sides, at least one side sees the
+ * other's final label and records the route through them.
+ *
+ * The search is generic over the graph (an expand function)
+ * and the keys (a potential), and is wrapped below for
+ * CsrGraphs (plain Dijkstra keys) and for GridMaps (the
+ * average-heuristic keys of bidirectional_a_star.h).
+ *******************************************************/
+
+#ifndef PARALLEL_BIDIRECTIONAL_H
+#define PARALLEL_BIDIRECTIONAL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "a_star.h"
+#include "bidirectional_a_star.h"
+#include "csr_graph.h"
+#include "grid_map.h"
+#include "parallel.h"
+#include "priority_queues.h"
+
+// Per-query state of a two-thread bidirectional search over numVertices
+// vertices, and the thread that runs the backward side. Like
+// SearchContext it is stamped per query, so it can be reused for any
+// number of queries; one query at a time.
+template <class Queue = BinaryHeap>
+class ParallelBidirectionalSearch {
+public:
+    explicit ParallelBidirectionalSearch(int numVertices)
+        : n_(numVertices), pool_(2)
+    {
+        for(int side = 0; side < 2; side++) {
+            labels_[side].reset(new std::atomic<uint64_t>[numVertices]);
+            for(int v = 0; v < numVertices; v++) labels_[side][v].store(0, std::memory_order_relaxed);
+            closed_[side].assign(numVertices, 0);
+            parent_[side].assign(numVertices, -1);
+        }
+    }
+
+    int numVertices() const { return n_; }
+
+    // Cost of the cheapest source-target route, or INT_MAX if there is
+    // none. keys.key(side, v, g) is the queue key of v reached by side
+    // with cost g, and keys.bound(cost) the key sum at the meeting vertex
+    // of a route costing cost; keys must be consistent (never decrease
+    // along an edge). expand(side, u, fn) calls fn(v, w) for every edge
+    // u -> v of weight w that side follows. Both are called from two
+    // threads at once.
+    template <class Keys, class Expand>
+    int run(int source, int target, const Keys& keys, Expand expand) {
+        beginQuery();
+        int ends[2] = {source, target};
+        for(int side = 0; side < 2; side++) {
+            queues_[side].reset(n_);
+            setLabel(side, ends[side], 0, -1);
+            lastKey_[side].store(keys.key(side, ends[side], 0), std::memory_order_relaxed);
+            queues_[side].push(keys.key(side, ends[side], 0), ends[side]);
+        }
+        meeting_ = source;
+        if(source == target) return 0;
+        best_.store(pack(kInf, 0));
+
+        // Worker 0 is this thread. A side that throws gives up its key, so
+        // the other one stops too; the pool rethrows the error.
+        pool_.forEachWorker([&](int side) {
+            try {
+                searchSide(side, keys, expand);
+            } catch(...) {
+                lastKey_[side].store(kInf);
+                throw;
+            }
+        });
+
+        uint64_t best = best_.load();
+        meeting_ = static_cast<int>(best & 0xffffffff);
+        return static_cast<int>(best >> 32);
+    }
+
+    // The vertex both halves of the last route run through, and the
+    // predecessor of v on the side's half (-1 at the side's own end).
+    // Parents stay valid until the next query.
+    int meetingVertex() const { return meeting_; }
+    int parent(int side, int v) const { return parent_[side][v]; }
+
+    // Vertices settled by each side in the last query.
+    int settled(int side) const { return settled_[side]; }
+
+private:
+    static const int kInf = std::numeric_limits<int>::max();
+
+    static uint64_t pack(int high, int low) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(high)) << 32) | static_cast<uint32_t>(low);
+    }
+
+    void beginQuery() {
+        settled_[0] = settled_[1] = 0;
+        if(++current_ == 0) {
+            for(int side = 0; side < 2; side++) {
+                for(int v = 0; v < n_; v++) labels_[side][v].store(0, std::memory_order_relaxed);
+                std::fill(closed_[side].begin(), closed_[side].end(), 0);
+            }
+            current_ = 1;
+        }
+    }
+
+    int label(int side, int v, std::memory_order order) const {
+        uint64_t packed = labels_[side][v].load(order);
+        return (packed >> 32) == current_ ? static_cast<int>(packed & 0xffffffff) : kInf;
+    }
+
+    void setLabel(int side, int v, int g, int parent) {
+        parent_[side][v] = parent;
+        labels_[side][v].store(pack(static_cast<int>(current_), g));
+    }
+
+    void offerRoute(int cost, int v) {
+        uint64_t offer = pack(cost, v);
+        uint64_t best = best_.load();
+        while(offer < best && !best_.compare_exchange_weak(best, offer)) {}
+    }
+
+    template <class Keys, class Expand>
+    void searchSide(int side, const Keys& keys, Expand& expand) {
+        Queue& queue = queues_[side];
+        const int other = 1 - side;
+        while(!queue.empty()) {
+            auto [currentKey, u] = queue.pop();
+            if(closed_[side][u] == current_) continue;
+            lastKey_[side].store(currentKey, std::memory_order_relaxed);
+
+            // The other side's key may be stale, but it is never too high
+            int otherKey = lastKey_[other].load(std::memory_order_relaxed);
+            int best = static_cast<int>(best_.load() >> 32);
+            if(otherKey == kInf ||
+               (best != kInf && static_cast<int64_t>(currentKey) + otherKey >= keys.bound(best))) {
+                return;
+            }
+            closed_[side][u] = current_;
+            settled_[side]++;
+
+            int gu = label(side, u, std::memory_order_relaxed);
+            expand(side, u, [&](int v, int w) {
+                int g = gu + w;
+                int gv = label(side, v, std::memory_order_relaxed);
+                if(g < gv && closed_[side][v] != current_) {
+                    setLabel(side, v, g, u);
+                    queue.push(keys.key(side, v, g), v);
+                    gv = g;
+                }
+                // Written our label first, now check theirs
+                int theirs = label(other, v, std::memory_order_seq_cst);
+                if(theirs != kInf) offerRoute(gv + theirs, v);
+            });
+        }
+        // Exhausted: every vertex this side can reach is settled, so the
+        // best route is final once its relaxations are published
+        lastKey_[side].store(kInf);
+    }
+
+    int n_;
+    std::unique_ptr<std::atomic<uint64_t>[]> labels_[2];  // stamp << 32 | g
+    std::vector<uint32_t> closed_[2];
+    std::vector<int> parent_[2];
+    Queue queues_[2];
+    WorkerPool pool_;
+    std::atomic<int> lastKey_[2];
+    std::atomic<uint64_t> best_{0};  // cost << 32 | meeting vertex
+    uint32_t current_ = 0;
+    int meeting_ = -1;
+    int settled_[2] = {0, 0};
+};
+
+// Keys for plain bidirectional Dijkstra: the cost itself.
+struct DijkstraKeys {
+    int key(int /*side*/, int /*v*/, int g) const { return g; }
+    int64_t bound(int cost) const { return cost; }
+};
+
+// Bidirectional Dijkstra on a CsrGraph with the two directions searched
+// concurrently. Returns the same distances as dijkstra(). For directed
+// graphs pass reverseCsrGraph(graph) as reverse; an undirected graph is
+// its own reverse.
+template <class Queue = BinaryHeap>
+class ParallelBidirectionalDijkstra {
+public:
+    ParallelBidirectionalDijkstra(const CsrGraph& graph, const CsrGraph& reverse)
+        : graphs_{&graph, &reverse}, search_(graph.numVertices())
+    {
+        if(reverse.numVertices() != graph.numVertices()) {
+            throw std::invalid_argument("ParallelBidirectionalDijkstra: reverse graph does not match");
+        }
+    }
+
+    // Shortest distance from source to target, or INT_MAX if unreachable.
+    int distance(int source, int target) {
+        return search_.run(source, target, DijkstraKeys(), [this](int side, int u, auto&& fn) {
+            const CsrGraph& graph = *graphs_[side];
+            for(int64_t e = graph.edgeBegin(u); e < graph.edgeEnd(u); e++) {
+                fn(graph.target(e), graph.weight(e));
+            }
+        });
+    }
+
+    // Vertices settled by the last query, both directions together.
+    int settled() const { return search_.settled(0) + search_.settled(1); }
+
+private:
+    const CsrGraph* graphs_[2];  // forward, reverse
+    ParallelBidirectionalSearch<Queue> search_;
+};
+
+// Bidirectional A* (see bidirectional_a_star.h) with the forward and
+// backward searches on separate threads. search must have been built
+// with grid.size() vertices and can be reused across queries.
+template <class OpenSet>
+std::vector<std::pair<int,int>> parallelBidirectionalAStarSearch(const GridMap& grid,
+                                                                 ParallelBidirectionalSearch<OpenSet>& search,
+                                                                 int startRow, int startCol,
+                                                                 int goalRow, int goalCol,
+                                                                 Connectivity connectivity = Connectivity::Four,
+                                                                 BidirectionalStats* stats = nullptr)
+{
+    if(search.numVertices() != grid.size()) {
+        throw std::invalid_argument("ParallelBidirectionalSearch does not match grid");
+    }
+    const BidirectionalGridKeys keys(grid, connectivity, startRow, startCol, goalRow, goalCol);
+    const GridMoves moves(grid, connectivity);
+    int cost = search.run(grid.index(startRow, startCol), grid.index(goalRow, goalCol), keys,
+                          [&](int /*side*/, int idx, auto&& fn) { moves.forEach(idx, fn); });
+    if(stats) {
+        stats->forwardExpansions = search.settled(0);
+        stats->backwardExpansions = search.settled(1);
+    }
+    if(cost == std::numeric_limits<int>::max()) return {};
+
+    // Start -> meeting cell, then the backward parents on to the goal
+    int meet = search.meetingVertex();
+    std::vector<std::pair<int,int>> path;
+    for(int idx = meet; idx != -1; idx = search.parent(0, idx)) {
+        path.push_back({grid.rowOf(idx), grid.colOf(idx)});
+    }
+    std::reverse(path.begin(), path.end());
+    for(int idx = search.parent(1, meet); idx != -1; idx = search.parent(1, idx)) {
+        path.push_back({grid.rowOf(idx), grid.colOf(idx)});
+    }
+    return path;
+}
+
+#endif // PARALLEL_BIDIRECTIONAL_H
@@ -0,0 +1,337 @@
+/*******************************************************
+ * Priority queues for the search algorithms
+ *
+ * Every queue orders (key, id) pairs by smallest key and
+ * shares one interface so searches can take the queue as
+ * a template parameter:
+ *   reset(numIds)  - empty the queue; ids are < numIds
+ *   push(key, id)  - insert an entry (indexed heaps:
+ *                    insert or decrease the id's key)
+ *   pop()          - remove and return the smallest entry
+ *   empty()
+ * Keys are non-negative ints (path costs). Queues marked
+ * monotone additionally require that no key pushed is
+ * smaller than the last key popped, which holds for
+ * Dijkstra and for A* with a consistent heuristic.
+ *******************************************************/
+
+#ifndef PRIORITY_QUEUES_H
+#define PRIORITY_QUEUES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Binary min-heap with lazy deletion: a better key for an id is pushed
+// as a new entry and the caller skips the stale one when it surfaces.
+class BinaryHeap {
+public:
+    void reset(int /*numIds*/) { heap_.clear(); }
+
+    bool empty() const { return heap_.empty(); }
+
+    void push(int key, int id) {
+        heap_.push_back({key, id});
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<std::pair<int,int>>());
+    }
+
+    std::pair<int,int> pop() {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<std::pair<int,int>>());
+        std::pair<int,int> top = heap_.back();
+        heap_.pop_back();
+        return top;
+    }
+
+private:
+    std::vector<std::pair<int,int>> heap_;
+};
+
+// Implicit D-ary min-heap with lazy deletion. A wider node (D = 4 or 8)
+// halves or thirds the tree depth and keeps a node's children in one
+// or two cache lines, trading a few extra comparisons on pop for fewer
+// cache misses on large heaps.
+template <int D>
+class DaryHeap {
+    static_assert(D >= 2, "DaryHeap needs at least two children per node");
+public:
+    void reset(int /*numIds*/) { heap_.clear(); }
+
+    bool empty() const { return heap_.empty(); }
+
+    void push(int key, int id) {
+        heap_.push_back({key, id});
+        siftUp(heap_.size() - 1);
+    }
+
+    std::pair<int,int> pop() {
+        std::pair<int,int> top = heap_.front();
+        heap_.front() = heap_.back();
+        heap_.pop_back();
+        if(!heap_.empty()) {
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    void siftUp(size_t pos) {
+        std::pair<int,int> entry = heap_[pos];
+        while(pos > 0) {
+            size_t parent = (pos - 1) / D;
+            if(!(entry < heap_[parent])) break;
+            heap_[pos] = heap_[parent];
+            pos = parent;
+        }
+        heap_[pos] = entry;
+    }
+
+    void siftDown(size_t pos) {
+        std::pair<int,int> entry = heap_[pos];
+        size_t size = heap_.size();
+        while(true) {
+            size_t first = pos * D + 1;
+            if(first >= size) break;
+            size_t last = std::min(first + D, size);
+            size_t best = first;
+            for(size_t child = first + 1; child < last; child++) {
+                if(heap_[child] < heap_[best]) best = child;
+            }
+            if(!(heap_[best] < entry)) break;
+            heap_[pos] = heap_[best];
+            pos = best;
+        }
+        heap_[pos] = entry;
+    }
+
+    std::vector<std::pair<int,int>> heap_;
+};
+
+// Indexed D-ary min-heap with true decrease-key. Each id has at most one
+// entry; pushing an id that is already queued lowers its key in place
+// (a larger key is ignored), so the heap never exceeds one entry per
+// vertex and pops never return stale entries. pos_ maps an id to its
+// heap slot and costs one int per id, allocated on the first reset.
+template <int D>
+class IndexedDaryHeap {
+    static_assert(D >= 2, "IndexedDaryHeap needs at least two children per node");
+public:
+    void reset(int numIds) {
+        if(static_cast<int>(pos_.size()) != numIds) {
+            pos_.assign(numIds, -1);
+        } else {
+            for(const auto& entry : heap_) {
+                pos_[entry.second] = -1;
+            }
+        }
+        heap_.clear();
+    }
+
+    bool empty() const { return heap_.empty(); }
+
+    bool contains(int id) const { return pos_[id] != -1; }
+
+    void push(int key, int id) {
+        int pos = pos_[id];
+        if(pos == -1) {
+            heap_.push_back({key, id});
+            siftUp(heap_.size() - 1);
+        } else if(key < heap_[pos].first) {
+            heap_[pos].first = key;
+            siftUp(pos);
+        }
+    }
+
+    std::pair<int,int> pop() {
+        std::pair<int,int> top = heap_.front();
+        pos_[top.second] = -1;
+        std::pair<int,int> last = heap_.back();
+        heap_.pop_back();
+        if(!heap_.empty()) {
+            heap_.front() = last;
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    void place(size_t slot, const std::pair<int,int>& entry) {
+        heap_[slot] = entry;
+        pos_[entry.second] = static_cast<int>(slot);
+    }
+
+    void siftUp(size_t pos) {
+        std::pair<int,int> entry = heap_[pos];
+        while(pos > 0) {
+            size_t parent = (pos - 1) / D;
+            if(!(entry < heap_[parent])) break;
+            place(pos, heap_[parent]);
+            pos = parent;
+        }
+        place(pos, entry);
+    }
+
+    void siftDown(size_t pos) {
+        std::pair<int,int> entry = heap_[pos];
+        size_t size = heap_.size();
+        while(true) {
+            size_t first = pos * D + 1;
+            if(first >= size) break;
+            size_t last = std::min(first + D, size);
+            size_t best = first;
+            for(size_t child = first + 1; child < last; child++) {
+                if(heap_[child] < heap_[best]) best = child;
+            }
+            if(!(heap_[best] < entry)) break;
+            place(pos, heap_[best]);
+            pos = best;
+        }
+        place(pos, entry);
+    }
+
+    std::vector<std::pair<int,int>> heap_;
+    std::vector<int> pos_;
+};
+
+// Monotone radix heap. Entries live in 33 buckets according to the
+// highest bit in which their key differs from the last popped key;
+// when bucket 0 runs dry the lowest non-empty bucket is redistributed
+// around its minimum. Each entry moves down at most 32 times, giving
+// O(log C) amortized operations with purely sequential bucket scans.
+class RadixHeap {
+public:
+    void reset(int /*numIds*/) {
+        for(auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        size_ = 0;
+        last_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    void push(int key, int id) {
+        if(key < 0 || static_cast<uint32_t>(key) < last_) {
+            throw std::logic_error("RadixHeap: key is below the last popped key");
+        }
+        buckets_[bucketFor(static_cast<uint32_t>(key))].push_back({key, id});
+        size_++;
+    }
+
+    std::pair<int,int> pop() {
+        if(buckets_[0].empty()) {
+            int i = 1;
+            while(buckets_[i].empty()) {
+                i++;
+            }
+            auto& source = buckets_[i];
+            last_ = static_cast<uint32_t>(std::min_element(source.begin(), source.end())->first);
+            for(const auto& entry : source) {
+                buckets_[bucketFor(static_cast<uint32_t>(entry.first))].push_back(entry);
+            }
+            source.clear();
+        }
+        std::pair<int,int> top = buckets_[0].back();
+        buckets_[0].pop_back();
+        size_--;
+        return top;
+    }
+
+private:
+    // 0 if key equals the last popped key, else 1 + index of the highest
+    // differing bit.
+    int bucketFor(uint32_t key) const {
+        uint32_t diff = key ^ last_;
+#if defined(__GNUC__) || defined(__clang__)
+        return diff == 0 ? 0 : 32 - __builtin_clz(diff);
+#else
+        int bucket = 0;
+        while(diff != 0) {
+            diff >>= 1;
+            bucket++;
+        }
+        return bucket;
+#endif
+    }
+
+    std::vector<std::pair<int,int>> buckets_[33];
+    size_t size_ = 0;
+    uint32_t last_ = 0;
+};
+
+// Monotone Dial's bucket queue for integer keys popped in non-decreasing order,
+// e.g. A* with a consistent heuristic on a grid with small integer step
+// costs. Push and pop are O(1) amortized as long as pushed keys stay
+// within a bounded distance of the last popped key, as they do there.
+// Pushed keys must not be below the last popped key.
+//
+// Buckets form a ring indexed by key modulo its capacity; the ring
+// doubles whenever a key lands further ahead than it can hold. Entries
+// within a bucket are popped LIFO, which favours the most recently
+// reached (deepest) cells among equal f-costs.
+class BucketQueue {
+public:
+    BucketQueue() : buckets_(64) {}
+
+    void reset(int /*numIds*/) {
+        for(auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        size_ = 0;
+        minKey_ = std::numeric_limits<int>::max();
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    void push(int key, int id) {
+        if(key < minKey_) {
+            // Only the first push after reset may lower the cursor
+            if(size_ != 0 || minKey_ != std::numeric_limits<int>::max()) {
+                throw std::logic_error("BucketQueue: key is below the last popped key");
+            }
+            minKey_ = key;
+        }
+        if(key - minKey_ >= static_cast<int>(buckets_.size())) {
+            grow(key - minKey_);
+        }
+        buckets_[key & mask()].push_back(id);
+        size_++;
+    }
+
+    std::pair<int,int> pop() {
+        while(buckets_[minKey_ & mask()].empty()) {
+            minKey_++;
+        }
+        auto& bucket = buckets_[minKey_ & mask()];
+        int id = bucket.back();
+        bucket.pop_back();
+        size_--;
+        return {minKey_, id};
+    }
+
+private:
+    int mask() const { return static_cast<int>(buckets_.size()) - 1; }
+
+    // Re-homes every bucket into a ring that can hold keys up to
+    // minKey_ + span.
+    void grow(int span) {
+        size_t capacity = buckets_.size();
+        while(capacity <= static_cast<size_t>(span)) {
+            capacity *= 2;
+        }
+        std::vector<std::vector<int>> larger(capacity);
+        for(int k = minKey_; k < minKey_ + static_cast<int>(buckets_.size()); k++) {
+            larger[k & (capacity - 1)].swap(buckets_[k & mask()]);
+        }
+        buckets_.swap(larger);
+    }
+
+    std::vector<std::vector<int>> buckets_;
+    size_t size_ = 0;
+    int minKey_ = std::numeric_limits<int>::max();  // Last popped key
+};
+
+#endif // PRIORITY_QUEUES_H
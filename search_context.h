@@ -0,0 +1,97 @@
+/*******************************************************
+ * SearchContext - reusable per-map scratch space for A*
+ *
+ * Search state is kept as parallel arrays indexed by the
+ * flat GridMap cell index:
+ *   g          - cost from the start
+ *   parent     - cell index of the predecessor
+ *   generation - query that last wrote g/parent
+ *   closed     - one bit per cell, stamped per 64-bit word
+ * The heuristic and f = g + h are recomputed on demand
+ * instead of being stored.
+ *
+ * A context is allocated once per map. Per-cell state is
+ * stamped with the id of the query that wrote it; anything
+ * carrying an older stamp is treated as unvisited, so
+ * starting a new query is O(1) and back-to-back searches
+ * cost what they expand rather than the size of the map.
+ *******************************************************/
+
+#ifndef SEARCH_CONTEXT_H
+#define SEARCH_CONTEXT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "grid_map.h"
+
+class SearchContext {
+public:
+    explicit SearchContext(const GridMap& grid)
+        : g_(grid.size(), 0), parent_(grid.size(), -1),
+          generation_(grid.size(), 0),
+          closedBits_((grid.size() + 63) / 64, 0),
+          closedGeneration_((grid.size() + 63) / 64, 0)
+    {}
+
+    // Number of cells this context was built for.
+    int size() const { return static_cast<int>(g_.size()); }
+
+    // Throws if the context was built for a differently sized map.
+    void checkGrid(const GridMap& grid) const {
+        if(grid.size() != size()) {
+            throw std::invalid_argument("SearchContext does not match grid");
+        }
+    }
+
+    // Starts a new query, invalidating all state from the previous one.
+    // Stamps are only cleared when the 32-bit query counter wraps.
+    void beginQuery() {
+        if(++query_ == 0) {
+            std::fill(generation_.begin(), generation_.end(), 0);
+            std::fill(closedGeneration_.begin(), closedGeneration_.end(), 0);
+            query_ = 1;
+        }
+    }
+
+    // g and parent are only meaningful once a cell has been visited
+    // in the current query.
+    bool visited(int idx) const { return generation_[idx] == query_; }
+
+    int g(int idx) const { return g_[idx]; }
+    int parent(int idx) const { return parent_[idx]; }
+
+    // Records a (better) route to idx and marks it visited.
+    void update(int idx, int g, int parent) {
+        g_[idx] = g;
+        parent_[idx] = parent;
+        generation_[idx] = query_;
+    }
+
+    bool isClosed(int idx) const {
+        size_t word = static_cast<size_t>(idx) >> 6;
+        return closedGeneration_[word] == query_ &&
+               ((closedBits_[word] >> (idx & 63)) & 1);
+    }
+
+    void close(int idx) {
+        size_t word = static_cast<size_t>(idx) >> 6;
+        if(closedGeneration_[word] != query_) {
+            closedGeneration_[word] = query_;
+            closedBits_[word] = 0;
+        }
+        closedBits_[word] |= uint64_t(1) << (idx & 63);
+    }
+
+private:
+    std::vector<int> g_;
+    std::vector<int> parent_;
+    std::vector<uint32_t> generation_;
+    std::vector<uint64_t> closedBits_;
+    std::vector<uint32_t> closedGeneration_;
+    uint32_t query_ = 0;
+};
+
+#endif // SEARCH_CONTEXT_H
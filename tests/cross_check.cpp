@@ -0,0 +1,283 @@
+/*******************************************************
+ * Randomized cross-check of every search engine
+ *
+ * Builds small random graphs and grids and compares each
+ * engine with the plain reference on the same input:
+ *   graphs - dijkstra<BinaryHeap> against the other queues,
+ *            delta-stepping, point-to-point and bidirectional
+ *            Dijkstra (also on two threads and in batches),
+ *            contraction hierarchies (serial and parallel
+ *            build) and ALT; component labels against
+ *            reachability.
+ *   grids  - aStarSearch path cost against JPS, JPS with bit
+ *            scans, JPS+, bidirectional A* (also on two
+ *            threads) and batches, for both connectivities;
+ *            HPA* paths must be valid and no shorter; static
+ *            and dynamic component labels against A*.
+ * Every returned path is checked step by step. Prints the
+ * first mismatch and exits 1, else prints OK.
+ *
+ * Build and run from the repository root with the same
+ * line as the tools, optionally under a sanitizer:
+ *   g++ -std=c++17 -pthread tests/cross_check.cpp -o cross_check
+ *   ./cross_check [seed] [iterations]
+ *******************************************************/
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../a_star.h"
+#include "../alt.h"
+#include "../batch_query.h"
+#include "../bidirectional_a_star.h"
+#include "../bit_grid.h"
+#include "../components.h"
+#include "../contraction_hierarchy.h"
+#include "../csr_graph.h"
+#include "../delta_stepping.h"
+#include "../dijkstra.h"
+#include "../grid_map.h"
+#include "../hpa.h"
+#include "../jps.h"
+#include "../jps_plus.h"
+#include "../parallel_bidirectional.h"
+#include "../priority_queues.h"
+#include "../search_context.h"
+
+namespace {
+
+const int INF = std::numeric_limits<int>::max();
+const long kNoPath = -1;
+
+int failures = 0;
+
+void fail(const std::string& what, int iteration) {
+    if(failures++ == 0) {
+        std::cerr << "FAIL (iteration " << iteration << "): " << what << "\n";
+    }
+}
+
+// Cost of a grid path, or kNoPath if it is empty. Sets valid to false if
+// a step is not a legal move between free cells or the ends are wrong.
+long pathCost(const GridMap& grid, const std::vector<std::pair<int,int>>& path,
+              Connectivity connectivity, int startRow, int startCol, int goalRow, int goalCol,
+              bool& valid)
+{
+    valid = true;
+    if(path.empty()) return kNoPath;
+    if(path.front() != std::make_pair(startRow, startCol) || path.back() != std::make_pair(goalRow, goalCol)) {
+        valid = false;
+    }
+    long cost = 0;
+    for(size_t i = 0; i < path.size(); i++) {
+        int row = path[i].first, col = path[i].second;
+        if(!grid.inBounds(row, col) || grid.blocked(row, col)) valid = false;
+        if(i == 0) continue;
+        int dRow = row - path[i - 1].first, dCol = col - path[i - 1].second;
+        if(std::abs(dRow) > 1 || std::abs(dCol) > 1 || (dRow == 0 && dCol == 0)) {
+            valid = false;
+        } else if(dRow != 0 && dCol != 0) {
+            // Diagonals must not cut past a blocked corner
+            if(connectivity == Connectivity::Four ||
+               grid.blocked(path[i - 1].first + dRow, path[i - 1].second) ||
+               grid.blocked(path[i - 1].first, path[i - 1].second + dCol)) {
+                valid = false;
+            }
+            cost += kDiagonalCost8;
+        } else {
+            cost += connectivity == Connectivity::Four ? 1 : kStraightCost8;
+        }
+    }
+    return cost;
+}
+
+CsrGraph randomGraph(std::mt19937& rng, int n, bool directed) {
+    int m = static_cast<int>(rng() % (4 * n + 1));
+    int maxWeight = rng() % 3 == 0 ? 2 : 1 + static_cast<int>(rng() % 1000);
+    CsrGraphBuilder builder(n);
+    for(int i = 0; i < m; i++) {
+        int u = rng() % n, v = rng() % n, w = rng() % (maxWeight + 1);
+        builder.addEdge(u, v, w);
+        if(!directed) builder.addEdge(v, u, w);
+    }
+    return builder.build();
+}
+
+GridMap randomGrid(std::mt19937& rng, int rows, int cols, int density) {
+    GridMap grid(rows, cols);
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++) {
+            grid.setBlocked(r, c, static_cast<int>(rng() % 100) < density);
+        }
+    }
+    return grid;
+}
+
+void checkGraph(std::mt19937& rng, int iteration) {
+    int n = 1 + static_cast<int>(rng() % (iteration % 10 == 0 ? 2000 : 60));
+    bool directed = rng() % 2;
+    CsrGraph graph = randomGraph(rng, n, directed);
+    CsrGraph reverse = reverseCsrGraph(graph);
+
+    // Single source: every queue and delta-stepping give the same vector
+    int source = rng() % n;
+    std::vector<int> dist = dijkstra<BinaryHeap>(graph, source);
+    if(dijkstra<DaryHeap<4>>(graph, source) != dist) fail("dijkstra<DaryHeap<4>>", iteration);
+    if(dijkstra<RadixHeap>(graph, source) != dist) fail("dijkstra<RadixHeap>", iteration);
+    if(dijkstra<IndexedDaryHeap<4>>(graph, source) != dist) fail("dijkstra<IndexedDaryHeap<4>>", iteration);
+    if(dijkstra<IndexedDaryHeap<8>>(graph, source) != dist) fail("dijkstra<IndexedDaryHeap<8>>", iteration);
+    for(int delta : {1, 7, defaultDelta(graph), 100000}) {
+        for(int threads : {1, 3}) {
+            if(deltaStepping(graph, source, delta, threads) != dist) {
+                fail("deltaStepping delta=" + std::to_string(delta) + " threads=" + std::to_string(threads),
+                     iteration);
+            }
+        }
+    }
+
+    // Point to point: every engine against the single-source distances
+    ContractionHierarchy ch = buildContractionHierarchy(graph);
+    ContractionHierarchy chParallel = buildContractionHierarchyParallel(graph, 3);
+    LandmarkTable landmarks = LandmarkTable::build(graph, std::min(n, 4), 2);
+    ChQuery chQuery(ch), chParallelQuery(chParallel);
+    AltQuery altQuery(graph, landmarks);
+    PointToPointDijkstra<BinaryHeap> p2p(graph, reverse);
+    ParallelBidirectionalDijkstra<BinaryHeap> parallelP2p(graph, reverse);
+    GraphComponents components(graph, 2);
+
+    std::vector<std::pair<int,int>> queries;
+    std::vector<int> expected;
+    for(int q = 0; q < 20; q++) {
+        int target = rng() % n;
+        int d = dist[target];
+        queries.push_back({source, target});
+        expected.push_back(d);
+        if(p2p.distance(source, target) != d) fail("PointToPointDijkstra::distance", iteration);
+        if(p2p.bidirectionalDistance(source, target) != d) fail("bidirectionalDistance", iteration);
+        if(parallelP2p.distance(source, target) != d) fail("ParallelBidirectionalDijkstra", iteration);
+        if(chQuery.distance(source, target) != d) fail("ChQuery", iteration);
+        if(chParallelQuery.distance(source, target) != d) fail("ChQuery (parallel build)", iteration);
+        if(altQuery.distance(source, target) != d) fail("AltQuery", iteration);
+        if(d != INF && !components.connected(source, target)) fail("GraphComponents split a path", iteration);
+        if(!directed && d == INF && components.connected(source, target)) {
+            fail("GraphComponents joined unreachable vertices", iteration);
+        }
+    }
+    BatchDijkstra<BinaryHeap> batch(graph, reverse, 3);
+    if(batch.run(queries, false) != expected) fail("BatchDijkstra", iteration);
+    if(batch.run(queries, true) != expected) fail("BatchDijkstra (bidirectional)", iteration);
+}
+
+void checkGrid(std::mt19937& rng, int iteration) {
+    int rows = 1 + static_cast<int>(rng() % 40), cols = 1 + static_cast<int>(rng() % 40);
+    GridMap grid = randomGrid(rng, rows, cols, static_cast<int>(rng() % 45));
+    std::vector<std::pair<int,int>> freeCells;
+    for(int r = 0; r < rows; r++) {
+        for(int c = 0; c < cols; c++) {
+            if(!grid.blocked(r, c)) freeCells.push_back({r, c});
+        }
+    }
+    if(freeCells.empty()) return;
+
+    GridComponents components(grid, 2);
+    BitGrid bits(grid);
+    SearchContext ctx(grid), backwardCtx(grid);
+    BinaryHeap openSet, backwardOpen;
+    BucketQueue bucket;
+    IndexedDaryHeap<4> indexed;
+
+    for(Connectivity connectivity : {Connectivity::Four, Connectivity::Eight}) {
+        JpsPlusTable jpsTable = JpsPlusTable::build(grid, connectivity, 2);
+        HpaGraph hpaGraph(grid, 2 + static_cast<int>(rng() % 8), connectivity, 2);
+        ParallelBidirectionalSearch<BinaryHeap> parallelSearch(grid.size());
+        BatchPathfinder<BinaryHeap> batch(grid, connectivity, 3);
+
+        std::vector<GridQuery> queries;
+        std::vector<long> expected;
+        for(int q = 0; q < 10; q++) {
+            auto start = freeCells[rng() % freeCells.size()];
+            auto goal = freeCells[rng() % freeCells.size()];
+            int sr = start.first, sc = start.second, gr = goal.first, gc = goal.second;
+            bool valid;
+            long best = pathCost(grid, aStarSearch(grid, ctx, openSet, sr, sc, gr, gc, connectivity),
+                                 connectivity, sr, sc, gr, gc, valid);
+            if(!valid) fail("aStarSearch returned an invalid path", iteration);
+            queries.push_back({sr, sc, gr, gc});
+            expected.push_back(best);
+
+            auto same = [&](const std::string& name, const std::vector<std::pair<int,int>>& path) {
+                bool ok;
+                long cost = pathCost(grid, path, connectivity, sr, sc, gr, gc, ok);
+                if(!ok) fail(name + " returned an invalid path", iteration);
+                if(cost != best) fail(name + " cost differs from aStarSearch", iteration);
+            };
+            same("aStarSearch<BucketQueue>", aStarSearch(grid, ctx, bucket, sr, sc, gr, gc, connectivity));
+            same("aStarSearch<IndexedDaryHeap<4>>", aStarSearch(grid, ctx, indexed, sr, sc, gr, gc, connectivity));
+            same("jumpPointSearch", jumpPointSearch(grid, ctx, openSet, sr, sc, gr, gc, connectivity));
+            same("jumpPointSearch (bits)", jumpPointSearch(grid, bits, ctx, openSet, sr, sc, gr, gc, connectivity));
+            same("jpsPlusSearch", jpsPlusSearch(grid, jpsTable, ctx, openSet, sr, sc, gr, gc));
+            same("bidirectionalAStarSearch",
+                 bidirectionalAStarSearch(grid, ctx, backwardCtx, openSet, backwardOpen, sr, sc, gr, gc, connectivity));
+            same("parallelBidirectionalAStarSearch",
+                 parallelBidirectionalAStarSearch(grid, parallelSearch, sr, sc, gr, gc, connectivity));
+
+            // HPA* is near-optimal: a valid path, never shorter, found iff one exists
+            bool ok;
+            long hpaCost = pathCost(grid, hpaSearch(grid, hpaGraph, ctx, openSet, sr, sc, gr, gc),
+                                    connectivity, sr, sc, gr, gc, ok);
+            if(!ok) fail("hpaSearch returned an invalid path", iteration);
+            if((hpaCost == kNoPath) != (best == kNoPath) || hpaCost < best) {
+                fail("hpaSearch cost is impossible", iteration);
+            }
+
+            if(components.connected(grid.index(sr, sc), grid.index(gr, gc)) != (best != kNoPath)) {
+                fail("GridComponents disagree with aStarSearch", iteration);
+            }
+        }
+
+        std::vector<std::vector<std::pair<int,int>>> paths = batch.run(queries);
+        for(size_t q = 0; q < queries.size(); q++) {
+            const GridQuery& query = queries[q];
+            bool ok;
+            long cost = pathCost(grid, paths[q], connectivity, query.startRow, query.startCol,
+                                 query.goalRow, query.goalCol, ok);
+            if(!ok || cost != expected[q]) fail("BatchPathfinder", iteration);
+        }
+    }
+
+    // Cell flips through the batch engine keep the labels exact
+    BatchPathfinder<BinaryHeap> editable(grid, Connectivity::Four, 2);
+    for(int flip = 0; flip < 30; flip++) {
+        editable.setBlocked(grid, rng() % rows, rng() % cols, rng() % 2);
+        GridComponents fresh(grid, 1);
+        for(int q = 0; q < 10; q++) {
+            int a = grid.index(rng() % rows, rng() % cols), b = grid.index(rng() % rows, rng() % cols);
+            if(editable.components().connected(a, b) != fresh.connected(a, b)) {
+                fail("DynamicGridComponents disagree after a flip", iteration);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned seed = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 1;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 100;
+    std::mt19937 rng(seed);
+    for(int i = 0; i < iterations && failures == 0; i++) {
+        checkGraph(rng, i);
+        checkGrid(rng, i);
+    }
+    if(failures > 0) {
+        std::cerr << failures << " check(s) failed (seed " << seed << ")\n";
+        return 1;
+    }
+    std::cout << "OK: " << iterations << " graphs and grids, seed " << seed << "\n";
+    return 0;
+}